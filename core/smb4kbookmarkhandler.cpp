@@ -8,11 +8,13 @@
 // application specific includes
 #include "smb4kbookmarkhandler.h"
 #include "smb4kbookmark.h"
+#include "smb4kdeferredwriter.h"
 #include "smb4khost.h"
 #include "smb4knotification.h"
 #include "smb4kprofilemanager.h"
 #include "smb4ksettings.h"
 #include "smb4kshare.h"
+#include "smb4ksnapshotcache.h"
 
 // Qt includes
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
@@ -20,8 +22,10 @@
 #else
 #include <qapplicationstatic.h>
 #endif
+#include <QDataStream>
 #include <QDir>
 #include <QFile>
+#include <QHash>
 #include <QMutableListIterator>
 #include <QTextStream>
 #include <QXmlStreamReader>
@@ -32,10 +36,109 @@
 
 using namespace Smb4KGlobal;
 
+//
+// The keys under which bookmarks are indexed
+//
+static QString urlKey(const QUrl &url)
+{
+    // NOTE: Since also user provided URLs can be bookmarked, the URLs are
+    // compared case insensitively.
+    return url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toLower();
+}
+
+static QString labelKey(const QString &label)
+{
+    return label.toUpper();
+}
+
+class Smb4KBookmarkIndex
+{
+public:
+    void add(const BookmarkPtr &bookmark)
+    {
+        bookmarks << bookmark;
+
+        // Like the list, the index returns the first bookmark for an URL or a label
+        QString url = urlKey(bookmark->url());
+
+        if (!urls.contains(url)) {
+            urls.insert(url, bookmark);
+        }
+
+        QString label = labelKey(bookmark->label());
+
+        if (!labels.contains(label)) {
+            labels.insert(label, bookmark);
+        }
+
+        QList<BookmarkPtr> &categoryBookmarks = categories[bookmark->categoryName()];
+
+        if (categoryBookmarks.isEmpty()) {
+            categoryNames << bookmark->categoryName();
+        }
+
+        categoryBookmarks << bookmark;
+    }
+
+    void remove(const BookmarkPtr &bookmark)
+    {
+        if (!bookmarks.removeOne(bookmark)) {
+            return;
+        }
+
+        QString url = urlKey(bookmark->url());
+
+        if (urls.value(url) == bookmark) {
+            urls.remove(url);
+
+            for (const BookmarkPtr &b : std::as_const(bookmarks)) {
+                if (urlKey(b->url()) == url) {
+                    urls.insert(url, b);
+                    break;
+                }
+            }
+        }
+
+        QString label = labelKey(bookmark->label());
+
+        if (labels.value(label) == bookmark) {
+            labels.remove(label);
+
+            for (const BookmarkPtr &b : std::as_const(bookmarks)) {
+                if (labelKey(b->label()) == label) {
+                    labels.insert(label, b);
+                    break;
+                }
+            }
+        }
+
+        auto category = categories.find(bookmark->categoryName());
+
+        if (category != categories.end()) {
+            category->removeOne(bookmark);
+
+            if (category->isEmpty()) {
+                categories.erase(category);
+                categoryNames.removeOne(bookmark->categoryName());
+            }
+        }
+    }
+
+    QList<BookmarkPtr> bookmarks;
+    QHash<QString, BookmarkPtr> urls;
+    QHash<QString, BookmarkPtr> labels;
+    QHash<QString, QList<BookmarkPtr>> categories;
+    QStringList categoryNames;
+};
+
 class Smb4KBookmarkHandlerPrivate
 {
 public:
     QList<BookmarkPtr> bookmarks;
+    Smb4KBookmarkIndex index;
+    QHash<QString, Smb4KBookmarkIndex> profileIndexes;
+    Smb4KDeferredWriter *writer;
+    QScopedPointer<Smb4KSnapshotCache> snapshot;
 };
 
 class Smb4KBookmarkHandlerStatic
@@ -58,6 +161,20 @@ Smb4KBookmarkHandler::Smb4KBookmarkHandler(QObject *parent)
         dir.mkpath(path);
     }
 
+    d->writer = new Smb4KDeferredWriter(path + QDir::separator() + QStringLiteral("bookmarks.xml"),
+                                        [this](QIODevice *device) {
+                                            return writeFile(device);
+                                        },
+                                        this);
+
+    d->snapshot.reset(new Smb4KSnapshotCache(path + QDir::separator() + QStringLiteral("bookmarks.xml"), 1));
+
+    connect(d->writer, &Smb4KDeferredWriter::fileWritten, this, [this]() {
+        d->snapshot->save([this](QDataStream &stream) {
+            writeSnapshot(stream);
+        });
+    });
+
     read();
 
     connect(Smb4KProfileManager::self(), &Smb4KProfileManager::profileRemoved, this, &Smb4KBookmarkHandler::slotProfileRemoved);
@@ -67,6 +184,8 @@ Smb4KBookmarkHandler::Smb4KBookmarkHandler(QObject *parent)
 
 Smb4KBookmarkHandler::~Smb4KBookmarkHandler()
 {
+    d->writer->flush();
+
     while (!d->bookmarks.isEmpty()) {
         d->bookmarks.takeFirst().clear();
     }
@@ -95,6 +214,7 @@ void Smb4KBookmarkHandler::addBookmarks(const QList<BookmarkPtr> &list, bool rep
 
             if (!Smb4KSettings::useProfiles() || bookmark->profile() == Smb4KSettings::activeProfile()) {
                 it.remove();
+                removeFromIndex(bookmark);
                 bookmark.clear();
             }
         }
@@ -133,21 +253,9 @@ void Smb4KBookmarkHandler::removeCategory(const QString &name)
 BookmarkPtr Smb4KBookmarkHandler::findBookmarkByUrl(const QUrl &url)
 {
     BookmarkPtr bookmark;
-    QList<BookmarkPtr> temporalBookmarkList = bookmarkList();
-
-    if (!url.isEmpty() && url.isValid() && !temporalBookmarkList.isEmpty()) {
-        for (const BookmarkPtr &b : std::as_const(temporalBookmarkList)) {
-            // NOTE: Since also user provided URLs can be bookmarked, we cannot use
-            // QUrl::matches() here, because it does not allow for case insensitive
-            // comparison.
-            if (QString::compare(url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 b->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                == 0) {
-                bookmark = b;
-                break;
-            }
-        }
+
+    if (!url.isEmpty() && url.isValid()) {
+        bookmark = activeIndex().urls.value(urlKey(url));
     }
 
     return bookmark;
@@ -155,62 +263,22 @@ BookmarkPtr Smb4KBookmarkHandler::findBookmarkByUrl(const QUrl &url)
 
 BookmarkPtr Smb4KBookmarkHandler::findBookmarkByLabel(const QString &label)
 {
-    BookmarkPtr bookmark;
-    QList<BookmarkPtr> temporalBookmarkList = bookmarkList();
-
-    for (const BookmarkPtr &b : std::as_const(temporalBookmarkList)) {
-        if (b->label().toUpper() == label.toUpper()) {
-            bookmark = b;
-            break;
-        }
-    }
-
-    return bookmark;
+    return activeIndex().labels.value(labelKey(label));
 }
 
 QList<BookmarkPtr> Smb4KBookmarkHandler::bookmarkList() const
 {
-    QList<BookmarkPtr> bookmarks;
-
-    if (Smb4KSettings::useProfiles()) {
-        for (const BookmarkPtr &bookmark : std::as_const(d->bookmarks)) {
-            if (bookmark->profile() == Smb4KProfileManager::self()->activeProfile()) {
-                bookmarks << bookmark;
-            }
-        }
-    } else {
-        bookmarks = d->bookmarks;
-    }
-
-    return bookmarks;
+    return activeIndex().bookmarks;
 }
 
 QList<BookmarkPtr> Smb4KBookmarkHandler::bookmarkList(const QString &categoryName) const
 {
-    QList<BookmarkPtr> bookmarks;
-    QList<BookmarkPtr> temporalBookmarkList = bookmarkList();
-
-    for (const BookmarkPtr &bookmark : std::as_const(temporalBookmarkList)) {
-        if (categoryName == bookmark->categoryName()) {
-            bookmarks << bookmark;
-        }
-    }
-
-    return bookmarks;
+    return activeIndex().categories.value(categoryName);
 }
 
 QStringList Smb4KBookmarkHandler::categoryList() const
 {
-    QStringList categories;
-    QList<BookmarkPtr> temporalBookmarkList = bookmarkList();
-
-    for (const BookmarkPtr &bookmark : std::as_const(temporalBookmarkList)) {
-        if (!categories.contains(bookmark->categoryName())) {
-            categories << bookmark->categoryName();
-        }
-    }
-
-    return categories;
+    return activeIndex().categoryNames;
 }
 
 bool Smb4KBookmarkHandler::isBookmarked(const SharePtr &share)
@@ -237,6 +305,7 @@ bool Smb4KBookmarkHandler::add(const BookmarkPtr &bookmark)
         }
 
         d->bookmarks << bookmark;
+        addToIndex(bookmark);
         addedBookmark = true;
     } else {
         Smb4KNotification::bookmarkExists(bookmark);
@@ -260,6 +329,7 @@ bool Smb4KBookmarkHandler::remove(const BookmarkPtr &bookmark)
                 == 0
             && bookmark->categoryName() == b->categoryName()) {
             it.remove();
+            removeFromIndex(b);
             removedBookmark = true;
             b.clear();
         }
@@ -278,6 +348,7 @@ bool Smb4KBookmarkHandler::remove(const QString &name)
 
         if ((!Smb4KSettings::useProfiles() || b->profile() == Smb4KProfileManager::self()->activeProfile()) && b->categoryName() == name) {
             it.remove();
+            removeFromIndex(b);
             removedCategory = true;
             b.clear();
         }
@@ -292,6 +363,33 @@ void Smb4KBookmarkHandler::read()
         d->bookmarks.takeFirst().clear();
     }
 
+    //
+    // Load the snapshot of the file, if it is up to date. Otherwise, read
+    // the file and take a new snapshot.
+    //
+    bool snapshotLoaded = d->snapshot->load([this](QDataStream &stream) {
+        return readSnapshot(stream);
+    });
+
+    if (!snapshotLoaded) {
+        while (!d->bookmarks.isEmpty()) {
+            d->bookmarks.takeFirst().clear();
+        }
+
+        if (readFile()) {
+            d->snapshot->save([this](QDataStream &stream) {
+                writeSnapshot(stream);
+            });
+        }
+    }
+
+    rebuildIndex();
+}
+
+bool Smb4KBookmarkHandler::readFile()
+{
+    bool success = true;
+
     QFile xmlFile(dataLocation() + QDir::separator() + QStringLiteral("bookmarks.xml"));
 
     if (xmlFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -350,52 +448,143 @@ void Smb4KBookmarkHandler::read()
 
         if (xmlReader.hasError()) {
             Smb4KNotification::readingFileFailed(xmlFile, xmlReader.errorString());
+            success = false;
         }
     } else {
         if (xmlFile.exists()) {
             Smb4KNotification::openingFileFailed(xmlFile);
+            success = false;
         }
     }
+    return success;
 }
 
 void Smb4KBookmarkHandler::write()
 {
-    QFile xmlFile(dataLocation() + QDir::separator() + QStringLiteral("bookmarks.xml"));
+    d->writer->scheduleWrite();
+}
 
-    if (!d->bookmarks.isEmpty()) {
-        if (xmlFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QXmlStreamWriter xmlWriter(&xmlFile);
-            xmlWriter.setAutoFormatting(true);
-            xmlWriter.writeStartDocument();
-            xmlWriter.writeStartElement(QStringLiteral("bookmarks"));
-            xmlWriter.writeAttribute(QStringLiteral("version"), QStringLiteral("3.1"));
-
-            for (const BookmarkPtr &bookmark : std::as_const(d->bookmarks)) {
-                if (!bookmark->url().isValid()) {
-                    Smb4KNotification::invalidURLPassed();
-                    continue;
-                }
+bool Smb4KBookmarkHandler::writeFile(QIODevice *device)
+{
+    if (d->bookmarks.isEmpty()) {
+        return false;
+    }
+
+    QXmlStreamWriter xmlWriter(device);
+    xmlWriter.setAutoFormatting(true);
+    xmlWriter.writeStartDocument();
+    xmlWriter.writeStartElement(QStringLiteral("bookmarks"));
+    xmlWriter.writeAttribute(QStringLiteral("version"), QStringLiteral("3.1"));
 
-                xmlWriter.writeStartElement(QStringLiteral("bookmark"));
-                xmlWriter.writeAttribute(QStringLiteral("profile"), bookmark->profile());
-                xmlWriter.writeAttribute(QStringLiteral("category"), bookmark->categoryName());
+    for (const BookmarkPtr &bookmark : std::as_const(d->bookmarks)) {
+        if (!bookmark->url().isValid()) {
+            Smb4KNotification::invalidURLPassed();
+            continue;
+        }
 
-                xmlWriter.writeTextElement(QStringLiteral("workgroup"), bookmark->workgroupName());
-                xmlWriter.writeTextElement(QStringLiteral("url"), bookmark->url().toString(QUrl::RemovePassword | QUrl::RemovePort));
-                xmlWriter.writeTextElement(QStringLiteral("ip"), bookmark->hostIpAddress());
-                xmlWriter.writeTextElement(QStringLiteral("label"), bookmark->label());
+        xmlWriter.writeStartElement(QStringLiteral("bookmark"));
+        xmlWriter.writeAttribute(QStringLiteral("profile"), bookmark->profile());
+        xmlWriter.writeAttribute(QStringLiteral("category"), bookmark->categoryName());
 
-                xmlWriter.writeEndElement();
-            }
+        xmlWriter.writeTextElement(QStringLiteral("workgroup"), bookmark->workgroupName());
+        xmlWriter.writeTextElement(QStringLiteral("url"), bookmark->url().toString(QUrl::RemovePassword | QUrl::RemovePort));
+        xmlWriter.writeTextElement(QStringLiteral("ip"), bookmark->hostIpAddress());
+        xmlWriter.writeTextElement(QStringLiteral("label"), bookmark->label());
 
-            xmlWriter.writeEndDocument();
+        xmlWriter.writeEndElement();
+    }
 
-            xmlFile.close();
-        } else {
-            Smb4KNotification::openingFileFailed(xmlFile);
+    xmlWriter.writeEndDocument();
+
+    return true;
+}
+
+const Smb4KBookmarkIndex &Smb4KBookmarkHandler::activeIndex() const
+{
+    if (Smb4KSettings::useProfiles()) {
+        static const Smb4KBookmarkIndex emptyIndex;
+        auto profileIndex = d->profileIndexes.constFind(Smb4KProfileManager::self()->activeProfile());
+
+        if (profileIndex != d->profileIndexes.constEnd()) {
+            return *profileIndex;
+        }
+
+        return emptyIndex;
+    }
+
+    return d->index;
+}
+
+void Smb4KBookmarkHandler::addToIndex(const BookmarkPtr &bookmark)
+{
+    d->index.add(bookmark);
+    d->profileIndexes[bookmark->profile()].add(bookmark);
+}
+
+void Smb4KBookmarkHandler::removeFromIndex(const BookmarkPtr &bookmark)
+{
+    d->index.remove(bookmark);
+
+    auto profileIndex = d->profileIndexes.find(bookmark->profile());
+
+    if (profileIndex != d->profileIndexes.end()) {
+        profileIndex->remove(bookmark);
+
+        if (profileIndex->bookmarks.isEmpty()) {
+            d->profileIndexes.erase(profileIndex);
+        }
+    }
+}
+
+void Smb4KBookmarkHandler::rebuildIndex()
+{
+    d->index = Smb4KBookmarkIndex();
+    d->profileIndexes.clear();
+
+    for (const BookmarkPtr &bookmark : std::as_const(d->bookmarks)) {
+        addToIndex(bookmark);
+    }
+}
+
+bool Smb4KBookmarkHandler::readSnapshot(QDataStream &stream)
+{
+    quint32 count = 0;
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString profile, categoryName, workgroupName, url, hostIpAddress, label;
+
+        stream >> profile >> categoryName >> workgroupName >> url >> hostIpAddress >> label;
+
+        BookmarkPtr bookmark = BookmarkPtr::create();
+        bookmark->setProfile(profile);
+        bookmark->setCategoryName(categoryName);
+        bookmark->setWorkgroupName(workgroupName);
+        bookmark->setUrl(QUrl(url));
+        bookmark->setHostIpAddress(hostIpAddress);
+        bookmark->setLabel(label);
+
+        d->bookmarks << bookmark;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+void Smb4KBookmarkHandler::writeSnapshot(QDataStream &stream)
+{
+    QList<BookmarkPtr> bookmarkList;
+
+    for (const BookmarkPtr &bookmark : std::as_const(d->bookmarks)) {
+        if (bookmark->url().isValid()) {
+            bookmarkList << bookmark;
         }
-    } else {
-        xmlFile.remove();
+    }
+
+    stream << quint32(bookmarkList.size());
+
+    for (const BookmarkPtr &bookmark : std::as_const(bookmarkList)) {
+        stream << bookmark->profile() << bookmark->categoryName() << bookmark->workgroupName()
+               << bookmark->url().toString(QUrl::RemovePassword | QUrl::RemovePort) << bookmark->hostIpAddress() << bookmark->label();
     }
 }
 
@@ -411,6 +600,8 @@ void Smb4KBookmarkHandler::slotProfileRemoved(const QString &name)
         }
     }
 
+    rebuildIndex();
+
     write();
     Q_EMIT updated();
 }
@@ -424,6 +615,8 @@ void Smb4KBookmarkHandler::slotProfileMigrated(const QString &oldName, const QSt
         }
     }
 
+    rebuildIndex();
+
     write();
     Q_EMIT updated();
 }
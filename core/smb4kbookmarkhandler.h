@@ -19,7 +19,10 @@
 #include <QUrl>
 
 // forward declarations
+class QDataStream;
+class QIODevice;
 class Smb4KBookmarkHandlerPrivate;
+class Smb4KBookmarkIndex;
 
 /**
  * This class belongs the to core classes of Smb4K and manages the
@@ -199,10 +202,54 @@ private:
     void read();
 
     /**
-     * Write the bookmarks to the file
+     * Read the bookmarks from the XML file. Returns FALSE if the file could
+     * not be read.
+     */
+    bool readFile();
+
+    /**
+     * Read the bookmarks from the snapshot @p stream. Returns FALSE if the
+     * snapshot is corrupted.
+     */
+    bool readSnapshot(QDataStream &stream);
+
+    /**
+     * Write the bookmarks to the snapshot @p stream.
+     */
+    void writeSnapshot(QDataStream &stream);
+
+    /**
+     * Schedule writing the bookmarks to the file
      */
     void write();
 
+    /**
+     * Write the bookmarks to @p device. Returns FALSE if there are no
+     * bookmarks.
+     */
+    bool writeFile(QIODevice *device);
+
+    /**
+     * Returns the index of the bookmarks that are visible with the current
+     * profile settings.
+     */
+    const Smb4KBookmarkIndex &activeIndex() const;
+
+    /**
+     * Add the @p bookmark to the index
+     */
+    void addToIndex(const BookmarkPtr &bookmark);
+
+    /**
+     * Remove the @p bookmark from the index
+     */
+    void removeFromIndex(const BookmarkPtr &bookmark);
+
+    /**
+     * Rebuild the index from the list of bookmarks
+     */
+    void rebuildIndex();
+
     /**
      * Pointer to Smb4KBookmarkHandlerPrivate class
      */
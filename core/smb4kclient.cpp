@@ -15,6 +15,8 @@
 #include "smb4khardwareinterface.h"
 #include "smb4khomesshareshandler.h"
 #include "smb4knotification.h"
+#include "smb4kprofilemanager.h"
+#include "smb4kresolver.h"
 #include "smb4ksettings.h"
 
 // Qt includes
@@ -24,25 +26,163 @@
 #else
 #include <qapplicationstatic.h>
 #endif
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
 #include <QHostAddress>
 #include <QPointer>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
 #include <QTimer>
 #include <QUdpSocket>
 
+#define BROWSE_CACHE_MAGIC 0x534d4b42
+#define BROWSE_CACHE_VERSION 1
+#define BROWSE_CACHE_MAX_AGE 604800
+
 using namespace Smb4KGlobal;
 
 Q_APPLICATION_STATIC(Smb4KClientStatic, p);
 
+//
+// Keys used to compare the known with the discovered network items
+//
+static QString workgroupKey(const WorkgroupPtr &workgroup)
+{
+    return workgroup->workgroupName().toCaseFolded();
+}
+
+static QString hostKey(const HostPtr &host)
+{
+    return host->workgroupName().toCaseFolded() + QStringLiteral("/") + host->hostName().toCaseFolded();
+}
+
+static QString shareKey(const SharePtr &share)
+{
+    return share->workgroupName().toCaseFolded() + QStringLiteral("/")
+        + share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded();
+}
+
+//
+// Compute the differences between the known and the discovered network items.
+// The items are hashed by their keys, so this is done in linear time. The known
+// items that were discovered again are returned together with their discovered
+// counterparts, so that they can be updated.
+//
+template<class T, class KeyFunction>
+static QList<std::pair<QSharedPointer<T>, QSharedPointer<T>>>
+diffNetworkItems(const QList<QSharedPointer<T>> &knownItems, const QList<QSharedPointer<T>> &discoveredItems, KeyFunction key, Smb4KClientDelta<T> *delta)
+{
+    QList<std::pair<QSharedPointer<T>, QSharedPointer<T>>> matchedItems;
+    QHash<QString, QSharedPointer<T>> knownIndex;
+    QSet<QString> discoveredKeys;
+
+    knownIndex.reserve(knownItems.size());
+    discoveredKeys.reserve(discoveredItems.size());
+
+    for (const QSharedPointer<T> &item : knownItems) {
+        knownIndex.insert(key(item), item);
+    }
+
+    for (const QSharedPointer<T> &item : discoveredItems) {
+        QString itemKey = key(item);
+
+        if (discoveredKeys.contains(itemKey)) {
+            continue;
+        }
+
+        discoveredKeys.insert(itemKey);
+
+        QSharedPointer<T> knownItem = knownIndex.value(itemKey);
+
+        if (knownItem) {
+            matchedItems << std::make_pair(knownItem, item);
+        } else {
+            delta->added << item;
+        }
+    }
+
+    for (const QSharedPointer<T> &item : knownItems) {
+        if (!discoveredKeys.contains(key(item))) {
+            delta->removed << item;
+        }
+    }
+
+    return matchedItems;
+}
+
+//
+// Check if updating a known network item with the discovered one changes
+// any of the properties that are shown to the user
+//
+static bool workgroupChanged(const WorkgroupPtr &knownWorkgroup, const WorkgroupPtr &workgroup)
+{
+    return knownWorkgroup->masterBrowserName() != workgroup->masterBrowserName()
+        || knownWorkgroup->masterBrowserIpAddress() != workgroup->masterBrowserIpAddress();
+}
+
+static bool hostChanged(const HostPtr &knownHost, const HostPtr &host)
+{
+    return knownHost->comment() != host->comment() || knownHost->isMasterBrowser() != host->isMasterBrowser()
+        || (!knownHost->hasIpAddress() && host->hasIpAddress());
+}
+
+static bool shareChanged(const SharePtr &knownShare, const SharePtr &share)
+{
+    return knownShare->comment() != share->comment() || knownShare->shareType() != share->shareType()
+        || knownShare->hostIpAddress() != share->hostIpAddress();
+}
+
 Smb4KClient::Smb4KClient(QObject *parent)
     : KCompositeJob(parent)
     , d(new Smb4KClientPrivate)
 {
+    d->searchRunning = false;
+    d->startingSearchJobs = false;
+    d->networkScanned = false;
+    d->resolverTimer.setSingleShot(true);
+    d->resolverTimer.setInterval(250);
+    d->threadPool.setMaxThreadCount(qMax(QThread::idealThreadCount(), Smb4KSettings::searchParallelism()));
+
+    //
+    // The client jobs use libsmbclient from several worker threads
+    // at the same time
+    //
+    smbc_thread_posix();
+
+    //
+    // Create the pool of libsmbclient contexts on the main thread, so that
+    // its eviction timer is run by the main event loop and not by the worker
+    // thread that uses it first
+    //
+    Smb4KClientContextPool::self();
+
+    connect(&d->resolverTimer, &QTimer::timeout, this, &Smb4KClient::slotPublishIpAddresses);
+    connect(Smb4KResolver::self(), &Smb4KResolver::ipAddressResolved, this, &Smb4KClient::slotIpAddressResolved);
     connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Smb4KClient::slotAboutToQuit);
     connect(Smb4KCredentialsManager::self(), &Smb4KCredentialsManager::credentialsUpdated, this, &Smb4KClient::slotCredentialsUpdated);
 }
 
 Smb4KClient::~Smb4KClient()
 {
+    //
+    // Release the worker threads that are waiting for the main thread and
+    // wait for them, so that no job is deleted while it is still using
+    // libsmbclient
+    //
+    QListIterator<KJob *> it(subjobs());
+
+    while (it.hasNext()) {
+        Smb4KClientJob *clientJob = qobject_cast<Smb4KClientJob *>(it.next());
+
+        if (clientJob) {
+            clientJob->cancel();
+        }
+    }
+
+    d->threadPool.waitForDone();
 }
 
 Smb4KClient *Smb4KClient::self()
@@ -56,6 +196,19 @@ void Smb4KClient::start()
     // Connect to the online state monitoring
     //
     connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::onlineStateChanged, this, &Smb4KClient::slotOnlineStateChanged, Qt::UniqueConnection);
+    connect(Smb4KHardwareInterface::self(),
+            &Smb4KHardwareInterface::networkAddressesChanged,
+            this,
+            &Smb4KClient::slotNetworkAddressesChanged,
+            Qt::UniqueConnection);
+
+    //
+    // Show the network neighborhood of the last session while it
+    // is being looked up again
+    //
+    if (Smb4KSettings::rememberNetworkNeighborhood() && workgroupsList().isEmpty()) {
+        loadBrowseCache();
+    }
 
     //
     // Start the scanning
@@ -72,11 +225,28 @@ bool Smb4KClient::isRunning()
 
 void Smb4KClient::abort()
 {
+    //
+    // Do not start any further lookups for a running search
+    //
+    d->searchQueue.clear();
+
     QListIterator<KJob *> it(subjobs());
 
     while (it.hasNext()) {
         it.next()->kill(KJob::EmitResult);
     }
+
+    //
+    // Forget about the pending IP address lookups
+    //
+    d->pendingLookups.clear();
+
+    //
+    // Finish the search, if no job is left that would do it
+    //
+    if (d->searchRunning && !hasSubjobs()) {
+        finishSearch();
+    }
 }
 
 void Smb4KClient::lookupDomains()
@@ -208,6 +378,11 @@ void Smb4KClient::lookupDomainMembers(const WorkgroupPtr &workgroup)
     clientJob->setNetworkItem(workgroup);
     clientJob->setProcess(LookupDomainMembers);
 
+    if (d->startingSearchJobs) {
+        clientJob->setTimeout(1000 * Smb4KSettings::searchHostTimeout());
+        clientJob->setSearchJob(true);
+    }
+
 #ifdef USE_WS_DISCOVERY
     //
     // Create the WS Discovery job, if desired
@@ -277,6 +452,18 @@ void Smb4KClient::lookupShares(const HostPtr &host)
     job->setNetworkItem(host);
     job->setProcess(LookupShares);
 
+    if (d->startingSearchJobs) {
+        job->setTimeout(1000 * Smb4KSettings::searchHostTimeout());
+        job->setSearchJob(true);
+    }
+
+    //
+    // Show the shares while they are still being looked up
+    //
+    connect(job, &Smb4KClientBaseJob::sharesDiscovered, this, [this, host](const QList<SharePtr> &list) {
+        processDiscoveredShares(host, list);
+    });
+
     //
     // Add the job to the subjobs
     //
@@ -300,6 +487,10 @@ void Smb4KClient::lookupFiles(const NetworkItemPtr &item)
         job->setNetworkItem(item);
         job->setProcess(LookupFiles);
 
+        connect(job, &Smb4KClientBaseJob::filesDiscovered, this, [this, job](const QList<FilePtr> &list) {
+            processDiscoveredFiles(job, list);
+        });
+
         addSubjob(job);
 
         Q_EMIT aboutToStart(item, LookupFiles);
@@ -345,61 +536,50 @@ void Smb4KClient::printFile(const SharePtr &share, const KFileItem &fileItem, in
 void Smb4KClient::search(const QString &item)
 {
     //
-    // Create empty basic network item
+    // Only one search can run at a time
     //
-    NetworkItemPtr networkItem = NetworkItemPtr::create();
+    if (d->searchRunning) {
+        return;
+    }
+
+    d->searchRunning = true;
+    d->searchString = item;
 
     //
-    // Emit the aboutToStart() signal
+    // Allow as many worker threads as parallel lookups are allowed
     //
-    Q_EMIT aboutToStart(networkItem, NetworkSearch);
+    d->threadPool.setMaxThreadCount(qMax(QThread::idealThreadCount(), Smb4KSettings::searchParallelism()));
 
     //
-    // Before doing the search, lookup all domains, servers and shares in the
-    // network neighborhood.
+    // Create empty basic network item
     //
-    lookupDomains();
-
-    while (isRunning()) {
-        wait(50);
-    }
-
-    for (const WorkgroupPtr &workgroup : workgroupsList()) {
-        lookupDomainMembers(workgroup);
-
-        while (isRunning()) {
-            wait(50);
-        }
-    }
-
-    for (const HostPtr &host : hostsList()) {
-        lookupShares(host);
-
-        while (isRunning()) {
-            wait(50);
-        }
-    }
+    d->searchItem = NetworkItemPtr::create();
 
     //
-    // Do the actual search
+    // Emit the aboutToStart() signal
     //
-    QList<SharePtr> results;
-
-    for (const SharePtr &share : sharesList()) {
-        if (share->shareName().contains(item, Qt::CaseInsensitive)) {
-            results << share;
-        }
-    }
+    Q_EMIT aboutToStart(d->searchItem, NetworkSearch);
 
     //
-    // Emit the search results
+    // Look up all domains. Their members and the shares are looked up
+    // concurrently by the search pipeline as soon as they become known
+    // and the matches are reported while the search is running.
     //
-    Q_EMIT searchResults(results);
+    lookupDomains();
+}
 
+bool Smb4KClient::addSubjob(KJob *job)
+{
     //
-    // Emit the finished() signal
+    // Let the client jobs do their work in the worker threads of this class
     //
-    Q_EMIT finished(networkItem, NetworkSearch);
+    Smb4KClientJob *clientJob = qobject_cast<Smb4KClientJob *>(job);
+
+    if (clientJob) {
+        clientJob->setThreadPool(&d->threadPool);
+    }
+
+    return KCompositeJob::addSubjob(job);
 }
 
 void Smb4KClient::processErrors(Smb4KClientBaseJob *job)
@@ -457,8 +637,22 @@ void Smb4KClient::processErrors(Smb4KClientBaseJob *job)
 
         break;
     }
+    case KJob::KilledJobError: {
+        //
+        // The job was aborted. There is nothing to report.
+        //
+        break;
+    }
     default: {
-        Smb4KNotification::networkCommunicationFailed(job->errorText());
+        //
+        // While searching, unreachable servers are just skipped. Errors of
+        // all other jobs are reported.
+        //
+        Smb4KClientJob *clientJob = qobject_cast<Smb4KClientJob *>(job);
+
+        if (!clientJob || !clientJob->isSearchJob()) {
+            Smb4KNotification::networkCommunicationFailed(job->errorText());
+        }
         break;
     }
     }
@@ -467,86 +661,96 @@ void Smb4KClient::processErrors(Smb4KClientBaseJob *job)
 void Smb4KClient::processWorkgroups(Smb4KClientBaseJob *job)
 {
     //
-    // Collect the workgroups found while scanning
+    // Collect the workgroups found while scanning. Duplicates are
+    // sorted out when the differences are computed.
     //
-    QList<WorkgroupPtr> discoveredWorkgroups = job->workgroups();
-
-    for (const WorkgroupPtr &newWorkgroup : std::as_const(discoveredWorkgroups)) {
-        bool foundWorkgroup = false;
-
-        for (const WorkgroupPtr &workgroup : std::as_const(d->tempWorkgroupList)) {
-            if (workgroup->workgroupName() == newWorkgroup->workgroupName()) {
-                foundWorkgroup = true;
-                break;
-            }
-        }
-
-        if (!foundWorkgroup) {
-            d->tempWorkgroupList << newWorkgroup;
-        }
-    }
+    d->tempWorkgroupList << job->workgroups();
 
     //
     // When scanning finished, process the workgroups
     //
-    if (!isRunning()) {
+    if (!hasSubjobsFor(job->networkItem())) {
+        Smb4KClientDelta<Smb4KWorkgroup> delta;
+        QList<std::pair<WorkgroupPtr, Smb4KClientDelta<Smb4KHost>>> hostsDeltas;
+        const QList<std::pair<WorkgroupPtr, WorkgroupPtr>> matchedWorkgroups =
+            diffNetworkItems(workgroupsList(), d->tempWorkgroupList, workgroupKey, &delta);
+
         // Remove obsolete workgroups and their members
-        QListIterator<WorkgroupPtr> it(workgroupsList());
+        for (const WorkgroupPtr &workgroup : std::as_const(delta.removed)) {
+            QList<HostPtr> obsoleteHosts = workgroupMembers(workgroup);
 
-        while (it.hasNext()) {
-            WorkgroupPtr workgroup = it.next();
+            while (!obsoleteHosts.isEmpty()) {
+                removeHost(obsoleteHosts.takeFirst());
+            }
 
-            bool foundWorkgroup = false;
+            removeWorkgroup(workgroup);
+        }
 
-            for (const WorkgroupPtr &w : std::as_const(d->tempWorkgroupList)) {
-                if (w->workgroupName() == workgroup->workgroupName()) {
-                    foundWorkgroup = true;
-                    break;
-                }
-            }
+        // Add new workgroups
+        QList<HostPtr> masterBrowsers;
 
-            if (!foundWorkgroup) {
-                QList<HostPtr> obsoleteHosts = workgroupMembers(workgroup);
+        for (const WorkgroupPtr &workgroup : std::as_const(delta.added)) {
+            addWorkgroup(workgroup);
 
-                while (!obsoleteHosts.isEmpty()) {
-                    removeHost(obsoleteHosts.takeFirst());
-                }
+            // Since this is a new workgroup, no master browser is present.
+            HostPtr masterBrowser = HostPtr::create();
+            masterBrowser->setWorkgroupName(workgroup->workgroupName());
+            masterBrowser->setHostName(workgroup->masterBrowserName());
+            masterBrowser->setIpAddress(workgroup->masterBrowserIpAddress());
+            masterBrowser->setIsMasterBrowser(true);
+
+            if (addHost(masterBrowser)) {
+                Smb4KClientDelta<Smb4KHost> hostsDelta;
+                hostsDelta.added << masterBrowser;
+                hostsDeltas << std::make_pair(workgroup, hostsDelta);
+            }
 
-                removeWorkgroup(workgroup);
+            if (workgroup->hasMasterBrowser()) {
+                masterBrowsers << masterBrowser;
             }
         }
 
-        // Add new workgroups and update existing ones
-        for (const WorkgroupPtr &workgroup : std::as_const(d->tempWorkgroupList)) {
-            if (!findWorkgroup(workgroup->workgroupName())) {
-                addWorkgroup(workgroup);
+        // Update existing workgroups
+        for (const auto &[knownWorkgroup, workgroup] : matchedWorkgroups) {
+            // Keep the known IP address of the master browser until it was looked up again
+            if (!workgroup->hasMasterBrowserIpAddress() && knownWorkgroup->masterBrowserName() == workgroup->masterBrowserName()) {
+                workgroup->setMasterBrowserIpAddress(knownWorkgroup->masterBrowserIpAddress());
+            }
 
-                // Since this is a new workgroup, no master browser is present.
-                HostPtr masterBrowser = HostPtr::create();
-                masterBrowser->setWorkgroupName(workgroup->workgroupName());
-                masterBrowser->setHostName(workgroup->masterBrowserName());
-                masterBrowser->setIpAddress(workgroup->masterBrowserIpAddress());
-                masterBrowser->setIsMasterBrowser(true);
+            if (workgroupChanged(knownWorkgroup, workgroup)) {
+                delta.changed << knownWorkgroup;
+            }
 
-                addHost(masterBrowser);
-            } else {
-                updateWorkgroup(workgroup);
+            updateWorkgroup(workgroup);
 
-                // Check if the master browser changed
-                QList<HostPtr> members = workgroupMembers(workgroup);
+            // Check if the master browser changed
+            Smb4KClientDelta<Smb4KHost> hostsDelta;
+            QList<HostPtr> members = workgroupMembers(knownWorkgroup);
 
-                for (const HostPtr &host : std::as_const(members)) {
-                    if (workgroup->masterBrowserName() == host->hostName()) {
-                        host->setIsMasterBrowser(true);
+            for (const HostPtr &host : std::as_const(members)) {
+                bool wasMasterBrowser = host->isMasterBrowser();
+                bool hadIpAddress = host->hasIpAddress();
 
-                        if (!host->hasIpAddress() && workgroup->hasMasterBrowserIpAddress()) {
-                            host->setIpAddress(workgroup->masterBrowserIpAddress());
-                        }
-                    } else {
-                        host->setIsMasterBrowser(false);
+                if (workgroup->masterBrowserName() == host->hostName()) {
+                    host->setIsMasterBrowser(true);
+
+                    if (!host->hasIpAddress() && workgroup->hasMasterBrowserIpAddress()) {
+                        host->setIpAddress(workgroup->masterBrowserIpAddress());
                     }
+
+                    masterBrowsers << host;
+                } else {
+                    host->setIsMasterBrowser(false);
+                }
+
+                if (host->isMasterBrowser() != wasMasterBrowser || host->hasIpAddress() != hadIpAddress) {
+                    hostsDelta.changed << host;
                 }
             }
+
+            if (!hostsDelta.isEmpty()) {
+                hostsDeltas << std::make_pair(knownWorkgroup, hostsDelta);
+            }
         }
 
         // Clear the temporary workgroup list
@@ -554,7 +758,38 @@ void Smb4KClient::processWorkgroups(Smb4KClientBaseJob *job)
             d->tempWorkgroupList.takeFirst().clear();
         }
 
+        if (!delta.isEmpty()) {
+            Q_EMIT workgroupsChanged(delta.added, delta.removed, delta.changed);
+        }
+
+        for (const auto &[workgroup, hostsDelta] : std::as_const(hostsDeltas)) {
+            Q_EMIT hostsChanged(workgroup, hostsDelta.added, hostsDelta.removed, hostsDelta.changed);
+        }
+
         Q_EMIT workgroups();
+
+        // Look up the IP addresses of the master browsers
+        lookupIpAddresses(masterBrowsers);
+
+        d->networkScanned = true;
+
+        // Revalidate the members of the workgroups loaded from the cache
+        if (!d->staleWorkgroups.isEmpty()) {
+            for (const WorkgroupPtr &workgroup : workgroupsList()) {
+                if (d->staleWorkgroups.remove(workgroup->workgroupName().toUpper()) && !d->searchRunning && !hasSubjobsFor(workgroup)) {
+                    lookupDomainMembers(workgroup);
+                }
+            }
+
+            d->staleWorkgroups.clear();
+        }
+
+        // Continue the search with the members of the workgroups
+        if (d->searchRunning) {
+            for (const WorkgroupPtr &workgroup : workgroupsList()) {
+                d->searchQueue << workgroup;
+            }
+        }
     }
 }
 
@@ -567,86 +802,127 @@ void Smb4KClient::processHosts(Smb4KClientBaseJob *job)
     //
     QList<HostPtr> discoveredHosts = job->hosts();
 
-    for (const HostPtr &newHost : std::as_const(discoveredHosts)) {
-        bool foundHost = false;
-
-        QMutableListIterator<HostPtr> it(d->tempHostList);
+    //
+    // Several workgroups might be scanned at the same time, so collect the
+    // hosts per workgroup.
+    //
+    WorkgroupPtr workgroup = job->networkItem().staticCast<Smb4KWorkgroup>();
+    QList<HostPtr> &tempHostList = d->tempHostLists[workgroup->workgroupName()];
+    QHash<QString, HostPtr> tempHostIndex;
 
-        while (it.hasNext()) {
-            HostPtr host = static_cast<HostPtr>(it.next());
+    tempHostIndex.reserve(tempHostList.size() + discoveredHosts.size());
 
-            if (newHost->url().matches(host->url(), QUrl::RemoveUserInfo | QUrl::RemovePort)) {
-                if (newHost->workgroupName() == host->workgroupName()) {
-                    foundHost = true;
-                } else if (host->dnsDiscovered()) {
-                    it.remove();
-                }
+    for (const HostPtr &host : std::as_const(tempHostList)) {
+        tempHostIndex.insert(host->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort), host);
+    }
 
-                break;
+    for (const HostPtr &newHost : std::as_const(discoveredHosts)) {
+        QString key = newHost->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort);
+        HostPtr host = tempHostIndex.value(key);
+
+        if (host) {
+            if (newHost->workgroupName() == host->workgroupName()) {
+                continue;
+            } else if (host->dnsDiscovered()) {
+                tempHostList.removeOne(host);
             }
         }
 
-        if (!foundHost) {
-            d->tempHostList << newHost;
-        }
+        tempHostList << newHost;
+        tempHostIndex.insert(key, newHost);
     }
 
     //
-    // When scanning finished, process the hosts
+    // When scanning the workgroup finished, process the hosts
     //
-    if (!isRunning()) {
-        // Get the workgroup pointer. Although several scans might have been
-        // running, the workgroup should have been always the same.
-        WorkgroupPtr workgroup = job->networkItem().staticCast<Smb4KWorkgroup>();
+    if (!hasSubjobsFor(workgroup)) {
+        for (const HostPtr &host : std::as_const(tempHostList)) {
+            if (host->hostName() == workgroup->masterBrowserName()) {
+                host->setIsMasterBrowser(true);
+            } else {
+                host->setIsMasterBrowser(false);
+            }
+        }
+
+        Smb4KClientDelta<Smb4KHost> delta;
+        const QList<std::pair<HostPtr, HostPtr>> matchedHosts = diffNetworkItems(workgroupMembers(workgroup), tempHostList, hostKey, &delta);
 
         // Remove obsolete workgroup/domain members
-        QList<HostPtr> members = workgroupMembers(workgroup);
-        QListIterator<HostPtr> it(members);
+        for (const HostPtr &host : std::as_const(delta.removed)) {
+            QList<SharePtr> obsoleteShares = sharedResources(host);
 
-        while (it.hasNext()) {
-            HostPtr host = it.next();
+            while (!obsoleteShares.isEmpty()) {
+                removeShare(obsoleteShares.takeFirst());
+            }
 
-            bool foundHost = false;
+            removeHost(host);
+        }
 
-            for (const HostPtr &h : std::as_const(d->tempHostList)) {
-                if (h->workgroupName() == host->workgroupName() && h->hostName() == host->hostName()) {
-                    foundHost = true;
-                    break;
-                }
-            }
+        // Add new hosts. Hosts that were discovered with a different
+        // domain might already be known.
+        QList<HostPtr> unresolvedHosts;
+        const QList<HostPtr> newHosts = delta.added;
+        delta.added.clear();
 
-            if (!foundHost) {
-                QList<SharePtr> obsoleteShares = sharedResources(host);
+        for (const HostPtr &host : newHosts) {
+            if (addHost(host)) {
+                delta.added << host;
+                unresolvedHosts << host;
+            } else {
+                HostPtr knownHost = findHost(host->hostName(), host->workgroupName());
 
-                while (!obsoleteShares.isEmpty()) {
-                    removeShare(obsoleteShares.takeFirst());
+                if (hostChanged(knownHost, host)) {
+                    delta.changed << knownHost;
                 }
 
-                removeHost(host);
+                updateHost(host);
+                unresolvedHosts << knownHost;
             }
         }
 
-        // Add new hosts and update existing ones
-        for (const HostPtr &host : std::as_const(d->tempHostList)) {
-            if (host->hostName() == workgroup->masterBrowserName()) {
-                host->setIsMasterBrowser(true);
-            } else {
-                host->setIsMasterBrowser(false);
+        // Update existing hosts
+        for (const auto &[knownHost, host] : matchedHosts) {
+            if (hostChanged(knownHost, host)) {
+                delta.changed << knownHost;
             }
 
-            if (!findHost(host->hostName(), host->workgroupName())) {
-                addHost(host);
-            } else {
-                updateHost(host);
-            }
+            updateHost(host);
+            unresolvedHosts << knownHost;
         }
 
         // Clear the temporary host list
-        while (!d->tempHostList.isEmpty()) {
-            d->tempHostList.takeFirst().clear();
+        while (!tempHostList.isEmpty()) {
+            tempHostList.takeFirst().clear();
+        }
+
+        d->tempHostLists.remove(workgroup->workgroupName());
+
+        if (!delta.isEmpty()) {
+            Q_EMIT hostsChanged(workgroup, delta.added, delta.removed, delta.changed);
         }
 
         Q_EMIT hosts(workgroup);
+
+        // Look up the IP addresses of the published hosts
+        lookupIpAddresses(unresolvedHosts);
+
+        // Revalidate the shares of the hosts loaded from the cache
+        if (!d->staleHosts.isEmpty()) {
+            for (const HostPtr &host : std::as_const(unresolvedHosts)) {
+                QString key = host->workgroupName().toUpper() + QStringLiteral("/") + host->hostName().toUpper();
+
+                if (d->staleHosts.remove(key) && !d->searchRunning && !hasSubjobsFor(host)) {
+                    lookupShares(host);
+                }
+            }
+        }
+
+        // Continue the search with the shares of the hosts
+        if (d->searchRunning) {
+            for (const HostPtr &host : std::as_const(unresolvedHosts)) {
+                d->searchQueue << host;
+            }
+        }
     }
 }
 
@@ -667,32 +943,36 @@ void Smb4KClient::processShares(Smb4KClientBaseJob *job)
     QList<SharePtr> discoveredShares = job->shares();
 
     //
-    // Remove obsolete shares
+    // Remove obsolete shares and the ones the user does not want to see
     //
-    QList<SharePtr> sharedRes = sharedResources(host);
-    QListIterator<SharePtr> it(sharedRes);
-
-    while (it.hasNext()) {
-        SharePtr share = it.next();
+    Smb4KClientDelta<Smb4KShare> delta;
+    const QList<std::pair<SharePtr, SharePtr>> matchedShares = diffNetworkItems(sharedResources(host), discoveredShares, shareKey, &delta);
 
-        bool foundShare = false;
-
-        for (const SharePtr &s : std::as_const(discoveredShares)) {
-            if (s->workgroupName() == share->workgroupName() && s->url().matches(share->url(), QUrl::RemoveUserInfo | QUrl::RemovePort)) {
-                foundShare = true;
-                break;
-            }
+    for (const auto &[knownShare, share] : matchedShares) {
+        if ((knownShare->isHidden() && !Smb4KSettings::detectHiddenShares()) || (knownShare->isPrinter() && !Smb4KSettings::detectPrinterShares())) {
+            delta.removed << knownShare;
         }
+    }
 
-        if (!foundShare || (share->isHidden() && !Smb4KSettings::detectHiddenShares()) || (share->isPrinter() && !Smb4KSettings::detectPrinterShares())) {
-            removeShare(share);
-        }
+    for (const SharePtr &share : std::as_const(delta.removed)) {
+        removeShare(share);
     }
 
     //
     // Add new shares and update existing ones
     //
-    for (const SharePtr &share : std::as_const(discoveredShares)) {
+    processDiscoveredShares(host, discoveredShares, delta.removed);
+}
+
+void Smb4KClient::processDiscoveredShares(const HostPtr &host, const QList<SharePtr> &list, const QList<SharePtr> &obsoleteShares)
+{
+    Smb4KClientDelta<Smb4KShare> delta;
+    delta.removed = obsoleteShares;
+
+    //
+    // Add new shares and update existing ones
+    //
+    for (const SharePtr &share : list) {
         // Process only those shares that the user wants to see
         if (share->isHidden() && !Smb4KSettings::detectHiddenShares()) {
             continue;
@@ -703,14 +983,45 @@ void Smb4KClient::processShares(Smb4KClientBaseJob *job)
         }
 
         // Add or update the shares
-        if (!findShare(share->url(), share->workgroupName())) {
-            addShare(share);
+        SharePtr knownShare = findShare(share->url(), share->workgroupName());
+
+        if (!knownShare) {
+            if (addShare(share)) {
+                delta.added << share;
+            }
         } else {
+            if (shareChanged(knownShare, share)) {
+                delta.changed << knownShare;
+            }
+
             updateShare(share);
         }
     }
 
+    if (!delta.isEmpty()) {
+        Q_EMIT sharesChanged(host, delta.added, delta.removed, delta.changed);
+    }
+
     Q_EMIT shares(host);
+
+    //
+    // Report the matches, if a search is running
+    //
+    if (d->searchRunning) {
+        QList<SharePtr> results;
+        QList<SharePtr> sharedRes = sharedResources(host);
+
+        for (const SharePtr &share : std::as_const(sharedRes)) {
+            if (share->shareName().contains(d->searchString, Qt::CaseInsensitive) && !d->searchResults.contains(share)) {
+                results << share;
+            }
+        }
+
+        if (!results.isEmpty()) {
+            d->searchResults << results;
+            Q_EMIT searchResults(results);
+        }
+    }
 }
 
 void Smb4KClient::processFiles(Smb4KClientBaseJob *job)
@@ -726,7 +1037,433 @@ void Smb4KClient::processFiles(Smb4KClientBaseJob *job)
         list << file;
     }
 
-    Q_EMIT files(list);
+    Q_EMIT files(job->networkItem()->url(), list);
+}
+
+void Smb4KClient::processDiscoveredFiles(Smb4KClientBaseJob *job, const QList<FilePtr> &list)
+{
+    QList<FilePtr> visibleFiles;
+
+    for (const FilePtr &file : list) {
+        if (file->isHidden() && !Smb4KSettings::previewHiddenItems()) {
+            continue;
+        }
+
+        visibleFiles << file;
+    }
+
+    if (!visibleFiles.isEmpty()) {
+        Q_EMIT filesDiscovered(job->networkItem()->url(), visibleFiles);
+    }
+}
+
+bool Smb4KClient::hasSubjobsFor(const NetworkItemPtr &item)
+{
+    const QList<KJob *> jobs = subjobs();
+
+    for (KJob *job : jobs) {
+        Smb4KClientBaseJob *clientBaseJob = qobject_cast<Smb4KClientBaseJob *>(job);
+
+        if (clientBaseJob && clientBaseJob->networkItem()->type() == item->type()
+            && clientBaseJob->networkItem()->url().matches(item->url(), QUrl::RemoveUserInfo | QUrl::RemovePort)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Smb4KClient::startSearchJobs()
+{
+    //
+    // Keep the number of concurrent lookups below the configured limit.
+    // The jobs started here are marked as search jobs.
+    //
+    d->startingSearchJobs = true;
+
+    while (d->searchRunning && !d->searchQueue.isEmpty() && subjobs().size() < Smb4KSettings::searchParallelism()) {
+        NetworkItemPtr item = d->searchQueue.takeFirst();
+
+        switch (item->type()) {
+        case Workgroup: {
+            lookupDomainMembers(item.staticCast<Smb4KWorkgroup>());
+            break;
+        }
+        case Host: {
+            lookupShares(item.staticCast<Smb4KHost>());
+            break;
+        }
+        default: {
+            break;
+        }
+        }
+    }
+
+    d->startingSearchJobs = false;
+}
+
+void Smb4KClient::finishSearch()
+{
+    d->searchRunning = false;
+    d->searchString.clear();
+    d->searchQueue.clear();
+    d->searchResults.clear();
+
+    Q_EMIT finished(d->searchItem, NetworkSearch);
+
+    d->searchItem.clear();
+}
+
+void Smb4KClient::lookupIpAddresses(const QList<HostPtr> &hosts)
+{
+    for (const HostPtr &host : hosts) {
+        //
+        // Use the cached IP address if possible
+        //
+        QHostAddress address;
+
+        if (Smb4KResolver::self()->cachedIpAddress(host->hostName(), &address)) {
+            processIpAddress(host, address);
+            continue;
+        }
+
+        //
+        // Otherwise resolve the host name asynchronously
+        //
+        QString key = host->hostName().toUpper();
+
+        if (!d->pendingLookups.contains(key, host)) {
+            d->pendingLookups.insert(key, host);
+        }
+
+        Smb4KResolver::self()->resolve(host->hostName());
+    }
+}
+
+void Smb4KClient::processIpAddress(const HostPtr &host, const QHostAddress &address)
+{
+    //
+    // The host might have been removed in the meantime
+    //
+    HostPtr knownHost = findHost(host->hostName(), host->workgroupName());
+
+    if (!knownHost) {
+        return;
+    }
+
+    WorkgroupPtr workgroup = findWorkgroup(knownHost->workgroupName());
+    Smb4KClientDelta<Smb4KHost> hostsDelta;
+
+    if (!address.isNull()) {
+        if (knownHost->ipAddress() != address.toString()) {
+            knownHost->setIpAddress(address);
+            hostsDelta.changed << knownHost;
+        }
+
+        if (knownHost->isMasterBrowser() && workgroup) {
+            if (workgroup->masterBrowserIpAddress() != address.toString()) {
+                workgroup->setMasterBrowserIpAddress(address);
+
+                if (!d->resolvedWorkgroupsDelta.changed.contains(workgroup)) {
+                    d->resolvedWorkgroupsDelta.changed << workgroup;
+                }
+            }
+        }
+    } else if (!knownHost->dnsDiscovered()) {
+        //
+        // If the address is null, the server most likely went offline. So, remove it
+        // together with its shares. If it was the master browser, the whole workgroup
+        // is not reachable anymore.
+        //
+        QList<HostPtr> obsoleteHosts;
+
+        if (knownHost->isMasterBrowser() && workgroup) {
+            obsoleteHosts = workgroupMembers(workgroup);
+        } else {
+            obsoleteHosts << knownHost;
+        }
+
+        while (!obsoleteHosts.isEmpty()) {
+            HostPtr obsoleteHost = obsoleteHosts.takeFirst();
+            QList<SharePtr> obsoleteShares = sharedResources(obsoleteHost);
+
+            while (!obsoleteShares.isEmpty()) {
+                removeShare(obsoleteShares.takeFirst());
+            }
+
+            removeHost(obsoleteHost);
+            hostsDelta.removed << obsoleteHost;
+        }
+
+        if (knownHost->isMasterBrowser() && workgroup) {
+            removeWorkgroup(workgroup);
+
+            d->resolvedWorkgroupsDelta.changed.removeAll(workgroup);
+            d->resolvedWorkgroupsDelta.removed << workgroup;
+        }
+    } else {
+        return;
+    }
+
+    //
+    // Publish the changes in batches
+    //
+    if (workgroup && !hostsDelta.isEmpty()) {
+        Smb4KClientDelta<Smb4KHost> &resolvedHostsDelta = d->resolvedHostsDeltas[workgroup->workgroupName()];
+
+        for (const HostPtr &changedHost : std::as_const(hostsDelta.changed)) {
+            if (!resolvedHostsDelta.changed.contains(changedHost)) {
+                resolvedHostsDelta.changed << changedHost;
+            }
+        }
+
+        for (const HostPtr &removedHost : std::as_const(hostsDelta.removed)) {
+            resolvedHostsDelta.changed.removeAll(removedHost);
+            resolvedHostsDelta.removed << removedHost;
+        }
+
+        if (!d->resolvedWorkgroups.contains(workgroup)) {
+            d->resolvedWorkgroups << workgroup;
+        }
+    }
+
+    if (!d->resolverTimer.isActive()) {
+        d->resolverTimer.start();
+    }
+}
+
+void Smb4KClient::loadBrowseCache()
+{
+    QFile cacheFile(dataLocation() + QDir::separator() + QStringLiteral("browse_cache.bin"));
+
+    if (!cacheFile.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    //
+    // Check the header. Only use a snapshot that was taken for the active
+    // profile and that is not too old.
+    //
+    quint32 magic = 0;
+    quint32 version = 0;
+
+    stream >> magic >> version;
+
+    if (magic != BROWSE_CACHE_MAGIC || version != BROWSE_CACHE_VERSION) {
+        return;
+    }
+
+    QString profile;
+    QDateTime timestamp;
+
+    stream >> profile >> timestamp;
+
+    if (profile != Smb4KProfileManager::self()->activeProfile() || !timestamp.isValid()
+        || timestamp.secsTo(QDateTime::currentDateTimeUtc()) > BROWSE_CACHE_MAX_AGE) {
+        return;
+    }
+
+    //
+    // Read the workgroups
+    //
+    QList<WorkgroupPtr> workgroups;
+    quint32 count = 0;
+
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString workgroupName, masterBrowserName, masterBrowserIpAddress;
+        bool dnsDiscovered = false;
+
+        stream >> workgroupName >> masterBrowserName >> masterBrowserIpAddress >> dnsDiscovered;
+
+        WorkgroupPtr workgroup = WorkgroupPtr::create();
+        workgroup->setWorkgroupName(workgroupName);
+        workgroup->setMasterBrowserName(masterBrowserName);
+        workgroup->setMasterBrowserIpAddress(masterBrowserIpAddress);
+        workgroup->setDnsDiscovered(dnsDiscovered);
+
+        workgroups << workgroup;
+    }
+
+    //
+    // Read the hosts
+    //
+    QList<HostPtr> hosts;
+    count = 0;
+
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString workgroupName, hostName, comment, ipAddress;
+        bool isMasterBrowser = false;
+        bool dnsDiscovered = false;
+
+        stream >> workgroupName >> hostName >> comment >> ipAddress >> isMasterBrowser >> dnsDiscovered;
+
+        HostPtr host = HostPtr::create();
+        host->setWorkgroupName(workgroupName);
+        host->setHostName(hostName);
+        host->setComment(comment);
+        host->setIpAddress(ipAddress);
+        host->setIsMasterBrowser(isMasterBrowser);
+        host->setDnsDiscovered(dnsDiscovered);
+
+        hosts << host;
+    }
+
+    //
+    // Read the shares
+    //
+    QList<SharePtr> shares;
+    count = 0;
+
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString workgroupName, hostName, shareName, comment, hostIpAddress;
+        qint32 shareType = FileShare;
+
+        stream >> workgroupName >> hostName >> shareName >> comment >> shareType >> hostIpAddress;
+
+        SharePtr share = SharePtr::create();
+        share->setWorkgroupName(workgroupName);
+        share->setHostName(hostName);
+        share->setShareName(shareName);
+        share->setComment(comment);
+        share->setShareType(static_cast<ShareType>(shareType));
+        share->setHostIpAddress(hostIpAddress);
+
+        shares << share;
+    }
+
+    //
+    // Do not use a damaged snapshot
+    //
+    if (stream.status() != QDataStream::Ok) {
+        return;
+    }
+
+    //
+    // Add the network items to the global lists. They are marked as stale,
+    // so that they are looked up again once the workgroups were scanned.
+    //
+    for (const WorkgroupPtr &workgroup : std::as_const(workgroups)) {
+        if (addWorkgroup(workgroup)) {
+            d->staleWorkgroups.insert(workgroup->workgroupName().toUpper());
+        }
+    }
+
+    for (const HostPtr &host : std::as_const(hosts)) {
+        if (findWorkgroup(host->workgroupName())) {
+            addHost(host);
+        }
+    }
+
+    for (const SharePtr &share : std::as_const(shares)) {
+        if (share->isHidden() && !Smb4KSettings::detectHiddenShares()) {
+            continue;
+        }
+
+        if (share->isPrinter() && !Smb4KSettings::detectPrinterShares()) {
+            continue;
+        }
+
+        if (findHost(share->hostName(), share->workgroupName()) && addShare(share)) {
+            d->staleHosts.insert(share->workgroupName().toUpper() + QStringLiteral("/") + share->hostName().toUpper());
+        }
+    }
+
+    //
+    // Publish the network neighborhood
+    //
+    Q_EMIT workgroupsChanged(workgroupsList(), QList<WorkgroupPtr>(), QList<WorkgroupPtr>());
+    Q_EMIT workgroups();
+
+    for (const WorkgroupPtr &workgroup : workgroupsList()) {
+        const QList<HostPtr> members = workgroupMembers(workgroup);
+
+        Q_EMIT hostsChanged(workgroup, members, QList<HostPtr>(), QList<HostPtr>());
+        Q_EMIT hosts(workgroup);
+
+        for (const HostPtr &host : members) {
+            const QList<SharePtr> sharedRes = sharedResources(host);
+
+            if (!sharedRes.isEmpty()) {
+                Q_EMIT sharesChanged(host, sharedRes, QList<SharePtr>(), QList<SharePtr>());
+                Q_EMIT shares(host);
+            }
+        }
+    }
+}
+
+void Smb4KClient::saveBrowseCache()
+{
+    //
+    // Only save the network neighborhood if it was looked up during this
+    // session. Otherwise the snapshot of the last session is kept.
+    //
+    if (!d->networkScanned) {
+        return;
+    }
+
+    QDir dir;
+
+    if (!dir.exists(dataLocation())) {
+        dir.mkpath(dataLocation());
+    }
+
+    QSaveFile cacheFile(dataLocation() + QDir::separator() + QStringLiteral("browse_cache.bin"));
+
+    if (!cacheFile.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    //
+    // Write the header
+    //
+    stream << quint32(BROWSE_CACHE_MAGIC) << quint32(BROWSE_CACHE_VERSION);
+    stream << Smb4KProfileManager::self()->activeProfile() << QDateTime::currentDateTimeUtc();
+
+    //
+    // Write the workgroups
+    //
+    stream << quint32(workgroupsList().size());
+
+    for (const WorkgroupPtr &workgroup : workgroupsList()) {
+        stream << workgroup->workgroupName() << workgroup->masterBrowserName() << workgroup->masterBrowserIpAddress() << workgroup->dnsDiscovered();
+    }
+
+    //
+    // Write the hosts
+    //
+    stream << quint32(hostsList().size());
+
+    for (const HostPtr &host : hostsList()) {
+        stream << host->workgroupName() << host->hostName() << host->comment() << host->ipAddress() << host->isMasterBrowser() << host->dnsDiscovered();
+    }
+
+    //
+    // Write the shares. No authentication data is saved.
+    //
+    stream << quint32(sharesList().size());
+
+    for (const SharePtr &share : sharesList()) {
+        stream << share->workgroupName() << share->hostName() << share->shareName() << share->comment() << qint32(share->shareType())
+               << share->hostIpAddress();
+    }
+
+    if (stream.status() == QDataStream::Ok) {
+        cacheFile.commit();
+    } else {
+        cacheFile.cancelWriting();
+    }
 }
 
 void Smb4KClient::slotStartJobs()
@@ -740,6 +1477,19 @@ void Smb4KClient::slotOnlineStateChanged(bool online)
         slotStartJobs();
     } else {
         abort();
+        Smb4KClientContextPool::self()->clear();
+    }
+}
+
+void Smb4KClient::slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed)
+{
+    Q_UNUSED(added);
+
+    //
+    // The connections of the idle contexts might use the removed addresses
+    //
+    if (!removed.isEmpty()) {
+        Smb4KClientContextPool::self()->clear();
     }
 }
 
@@ -800,6 +1550,13 @@ void Smb4KClient::slotResult(KJob *job)
         processErrors(clientBaseJob);
     }
 
+    //
+    // Start the next lookups of a running search
+    //
+    if (d->searchRunning) {
+        startSearchJobs();
+    }
+
     //
     // Emit the finished signal when all subjobs finished
     //
@@ -807,6 +1564,13 @@ void Smb4KClient::slotResult(KJob *job)
         Q_EMIT finished(networkItem, process);
     }
 
+    //
+    // Finish the search when there is nothing left to look up
+    //
+    if (d->searchRunning && !hasSubjobs() && d->searchQueue.isEmpty()) {
+        finishSearch();
+    }
+
     //
     // Clear the network item pointer
     //
@@ -815,7 +1579,12 @@ void Smb4KClient::slotResult(KJob *job)
 
 void Smb4KClient::slotAboutToQuit()
 {
+    if (Smb4KSettings::rememberNetworkNeighborhood()) {
+        saveBrowseCache();
+    }
+
     abort();
+    Smb4KClientContextPool::self()->clear();
 }
 
 void Smb4KClient::slotAbort()
@@ -823,8 +1592,46 @@ void Smb4KClient::slotAbort()
     abort();
 }
 
+void Smb4KClient::slotIpAddressResolved(const QString &name, const QHostAddress &address)
+{
+    QList<HostPtr> hosts = d->pendingLookups.values(name);
+    d->pendingLookups.remove(name);
+
+    for (const HostPtr &host : std::as_const(hosts)) {
+        processIpAddress(host, address);
+    }
+}
+
+void Smb4KClient::slotPublishIpAddresses()
+{
+    if (!d->resolvedWorkgroupsDelta.isEmpty()) {
+        Q_EMIT workgroupsChanged(d->resolvedWorkgroupsDelta.added, d->resolvedWorkgroupsDelta.removed, d->resolvedWorkgroupsDelta.changed);
+        Q_EMIT workgroups();
+        d->resolvedWorkgroupsDelta.clear();
+    }
+
+    while (!d->resolvedWorkgroups.isEmpty()) {
+        WorkgroupPtr workgroup = d->resolvedWorkgroups.takeFirst();
+        Smb4KClientDelta<Smb4KHost> delta = d->resolvedHostsDeltas.take(workgroup->workgroupName());
+
+        //
+        // The members of a removed workgroup went away with it
+        //
+        if (findWorkgroup(workgroup->workgroupName())) {
+            Q_EMIT hostsChanged(workgroup, delta.added, delta.removed, delta.changed);
+            Q_EMIT hosts(workgroup);
+        }
+    }
+}
+
 void Smb4KClient::slotCredentialsUpdated(const QUrl &url)
 {
+    //
+    // The pooled contexts might still hold sessions that were
+    // authenticated with the old credentials.
+    //
+    Smb4KClientContextPool::self()->clear();
+
     if (!url.isEmpty() && !d->queue.isEmpty()) {
         QMutableListIterator<Smb4KClientPrivate::QueueContainer> it(d->queue);
 
@@ -20,6 +20,8 @@
 #include <KFileItem>
 
 // forward declarations
+class QHostAddress;
+class QNetworkAddressEntry;
 class Smb4KClientPrivate;
 class Smb4KBasicNetworkItem;
 class Smb4KClientBaseJob;
@@ -106,7 +108,9 @@ public:
     void printFile(const SharePtr &share, const KFileItem &fileItem, int copies);
 
     /**
-     * Perform a search on the entire network neighborhood
+     * Perform a search on the entire network neighborhood. The workgroups
+     * and hosts are enumerated concurrently and the matches are reported
+     * by the searchResults() signal as they are found.
      *
      * @param item            The search item
      */
@@ -148,17 +152,65 @@ Q_SIGNALS:
      */
     void shares(const HostPtr &host);
 
+    /**
+     * Emitted when workgroups were added to, removed from or changed in the
+     * global list of workgroups. This signal is emitted together with the
+     * workgroups() signal, but only carries the differences. When a workgroup
+     * is removed, its members and their shares are removed as well without
+     * being reported separately.
+     *
+     * @param added         The new workgroups
+     * @param removed       The obsolete workgroups
+     * @param changed       The workgroups whose properties changed
+     */
+    void workgroupsChanged(const QList<WorkgroupPtr> &added, const QList<WorkgroupPtr> &removed, const QList<WorkgroupPtr> &changed);
+
+    /**
+     * Emitted when members of the workgroup @p workgroup were added to, removed
+     * from or changed in the global list of hosts. When a host is removed, its
+     * shares are removed as well without being reported separately.
+     *
+     * @param workgroup     The workgroup
+     * @param added         The new hosts
+     * @param removed       The obsolete hosts
+     * @param changed       The hosts whose properties changed
+     */
+    void hostsChanged(const WorkgroupPtr &workgroup, const QList<HostPtr> &added, const QList<HostPtr> &removed, const QList<HostPtr> &changed);
+
+    /**
+     * Emitted when shares of the host @p host were added to, removed from or
+     * changed in the global list of shares.
+     *
+     * @param host          The host
+     * @param added         The new shares
+     * @param removed       The obsolete shares
+     * @param changed       The shares whose properties changed
+     */
+    void sharesChanged(const HostPtr &host, const QList<SharePtr> &added, const QList<SharePtr> &removed, const QList<SharePtr> &changed);
+
     /**
      * Emitted when the requested list of files and directories was acquired
      *
+     * @param url           The URL of the share or directory that was looked up
      * @param list          The list of files and directories
      */
-    void files(const QList<FilePtr> &list);
+    void files(const QUrl &url, const QList<FilePtr> &list);
+
+    /**
+     * Emitted while files and directories are still being looked up. The
+     * list only contains the newly discovered items. When the lookup
+     * finished, the complete list is emitted by the files() signal.
+     *
+     * @param url           The URL of the share or directory that is looked up
+     * @param list          The list of new files and directories
+     */
+    void filesDiscovered(const QUrl &url, const QList<FilePtr> &list);
 
     /**
-     * Emitted when a search was done
+     * Emitted when matches were found while searching. This signal might
+     * be emitted several times during one search.
      *
-     * @param list          The list of search results
+     * @param list          The list of new search results
      */
     void searchResults(const QList<SharePtr> &list);
 
@@ -170,6 +222,13 @@ Q_SIGNALS:
      */
     void requestCredentials(const NetworkItemPtr &networkItem);
 
+protected:
+    /**
+     * Add a subjob. Reimplemented from KCompositeJob to run the client
+     * jobs in the worker threads of this class.
+     */
+    bool addSubjob(KJob *job) override;
+
 protected Q_SLOTS:
     /**
      * Start the composite job
@@ -181,6 +240,12 @@ protected Q_SLOTS:
      */
     void slotOnlineStateChanged(bool online);
 
+    /**
+     * React on IP addresses that were assigned to or removed from the
+     * network interfaces
+     */
+    void slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed);
+
     /**
      * Called when a job finished. Reimplemented from KCompositeJob.
      */
@@ -201,6 +266,16 @@ protected Q_SLOTS:
      */
     void slotCredentialsUpdated(const QUrl &url);
 
+    /**
+     * Called when a host name was resolved
+     */
+    void slotIpAddressResolved(const QString &name, const QHostAddress &address);
+
+    /**
+     * Called when IP addresses that were looked up are to be published
+     */
+    void slotPublishIpAddresses();
+
 private:
     /**
      * Process errors
@@ -228,6 +303,18 @@ private:
      */
     void processShares(Smb4KClientBaseJob *job);
 
+    /**
+     * Add the shares of @p host discovered so far to the global list
+     * of shares and report them
+     *
+     * @param host            The host
+     *
+     * @param list            The list of shares
+     *
+     * @param obsoleteShares  The shares that were removed from the global list
+     */
+    void processDiscoveredShares(const HostPtr &host, const QList<SharePtr> &list, const QList<SharePtr> &obsoleteShares = QList<SharePtr>());
+
     /**
      * Process the files and directories
      *
@@ -235,6 +322,60 @@ private:
      */
     void processFiles(Smb4KClientBaseJob *job);
 
+    /**
+     * Process the files and directories discovered so far
+     *
+     * @param job             The client job
+     *
+     * @param list            The list of files and directories
+     */
+    void processDiscoveredFiles(Smb4KClientBaseJob *job, const QList<FilePtr> &list);
+
+    /**
+     * Returns TRUE if there are subjobs running for the network item @p item
+     *
+     * @param item            The network item
+     */
+    bool hasSubjobsFor(const NetworkItemPtr &item);
+
+    /**
+     * Start queued lookups of a running search
+     */
+    void startSearchJobs();
+
+    /**
+     * Finish the running search
+     */
+    void finishSearch();
+
+    /**
+     * Queue the hosts for the asynchronous lookup of their IP addresses
+     *
+     * @param hosts           The list of hosts
+     */
+    void lookupIpAddresses(const QList<HostPtr> &hosts);
+
+    /**
+     * Process the IP address that was looked up for a host
+     *
+     * @param host            The host
+     *
+     * @param address         The IP address or a null address, if the lookup failed
+     */
+    void processIpAddress(const HostPtr &host, const QHostAddress &address);
+
+    /**
+     * Load the network neighborhood of the last session. The loaded
+     * workgroups, hosts and shares are regarded as stale until they
+     * were looked up again.
+     */
+    void loadBrowseCache();
+
+    /**
+     * Save the network neighborhood for the next session
+     */
+    void saveBrowseCache();
+
     /**
      * Pointer to the Smb4KClientPrivate class
      */
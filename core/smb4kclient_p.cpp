@@ -11,6 +11,7 @@
 #include "smb4kcustomsettings.h"
 #include "smb4kcustomsettingsmanager.h"
 #include "smb4knotification.h"
+#include "smb4kresolver.h"
 #include "smb4ksettings.h"
 
 // System includes
@@ -18,13 +19,17 @@
 #include <sys/stat.h>
 
 // Qt includes
-#include <QAbstractSocket>
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
+#include <QApplicationStatic>
+#else
+#include <qapplicationstatic.h>
+#endif
+#include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QDir>
-#include <QHostInfo>
-#include <QNetworkInterface>
 #include <QPrinter>
-#include <QTemporaryDir>
+#include <QSemaphore>
 #include <QTextDocument>
 #include <QUuid>
 
@@ -41,9 +46,15 @@
 #endif
 
 #define SMBC_DEBUG 0
+#define CONTEXT_POOL_MAX_SIZE 8
+#define CONTEXT_POOL_IDLE_TIMEOUT 60000
+#define STREAMING_BATCH_SIZE 100
+#define STREAMING_BATCH_INTERVAL 250
 
 using namespace Smb4KGlobal;
 
+Q_APPLICATION_STATIC(Smb4KClientContextPoolStatic, pool);
+
 //
 // Client base job
 //
@@ -119,64 +130,6 @@ QList<FilePtr> Smb4KClientBaseJob::files()
     return m_files;
 }
 
-QHostAddress Smb4KClientBaseJob::lookupIpAddress(const QString &name)
-{
-    //
-    // The IP address object
-    //
-    QHostAddress ipAddress;
-
-    //
-    // Get the IP address
-    //
-    // If the IP address is not to be determined for the local machine, we can use QHostInfo to
-    // determine it. Otherwise we need to use QNetworkInterface for it.
-    //
-    if (name.toUpper() == QHostInfo::localHostName().toUpper() || name.toUpper() == machineNetbiosName().toUpper()) {
-        // FIXME: Do we need to honor 'interfaces' here?
-        QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
-
-        // Get the IP address for the host. For the time being, prefer the
-        // IPv4 address over the IPv6 address.
-        for (const QHostAddress &addr : std::as_const(addresses)) {
-            // We only use global addresses.
-            if (addr.isGlobal()) {
-                if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
-                    ipAddress = addr;
-                    break;
-                } else if (addr.protocol() == QAbstractSocket::IPv6Protocol) {
-                    // FIXME: Use the right address here.
-                    ipAddress = addr;
-                }
-            }
-        }
-    } else {
-        // Get the IP address
-        QHostInfo hostInfo = QHostInfo::fromName(name);
-
-        if (hostInfo.error() == QHostInfo::NoError) {
-            QList<QHostAddress> addresses = hostInfo.addresses();
-
-            // Get the IP address for the host. For the time being, prefer the
-            // IPv4 address over the IPv6 address.
-            for (const QHostAddress &addr : std::as_const(addresses)) {
-                // We only use global addresses.
-                if (addr.isGlobal()) {
-                    if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
-                        ipAddress = addr;
-                        break;
-                    } else if (addr.protocol() == QAbstractSocket::IPv6Protocol) {
-                        // FIXME: Use the right address here.
-                        ipAddress = addr;
-                    }
-                }
-            }
-        }
-    }
-
-    return ipAddress;
-}
-
 //
 // Authentication function for libsmbclient
 //
@@ -204,11 +157,24 @@ static void get_auth_data_with_context_fn(SMBCCTX *context,
 //
 Smb4KClientJob::Smb4KClientJob(QObject *parent)
     : Smb4KClientBaseJob(parent)
+    , m_context(nullptr)
+    , m_copies(0)
+    , m_timeout(0)
+    , m_searchJob(false)
+    , m_threadPool(nullptr)
+    , m_cancelled(0)
+    , m_working(false)
+    , m_dnsDiscovered(false)
+    , m_masterBrowsersRequireAuth(false)
+    , m_hasAuthData(false)
+    , m_tempDir(nullptr)
+    , m_errorCode(NoError)
 {
 }
 
 Smb4KClientJob::~Smb4KClientJob()
 {
+    delete m_tempDir;
 }
 
 void Smb4KClientJob::start()
@@ -237,6 +203,47 @@ int Smb4KClientJob::printCopies() const
     return m_copies;
 }
 
+void Smb4KClientJob::setTimeout(int timeout)
+{
+    m_timeout = timeout;
+}
+
+int Smb4KClientJob::timeout() const
+{
+    return m_timeout;
+}
+
+void Smb4KClientJob::setSearchJob(bool search)
+{
+    m_searchJob = search;
+}
+
+bool Smb4KClientJob::isSearchJob() const
+{
+    return m_searchJob;
+}
+
+void Smb4KClientJob::setThreadPool(QThreadPool *pool)
+{
+    m_threadPool = pool;
+}
+
+void Smb4KClientJob::cancel()
+{
+    m_cancelled.storeRelease(1);
+}
+
+bool Smb4KClientJob::doKill()
+{
+    cancel();
+
+    //
+    // The worker thread cannot be interrupted and still uses this job. The
+    // job is finished in slotFinishWork() after the worker thread returned.
+    //
+    return !m_working;
+}
+
 void Smb4KClientJob::get_auth_data_fn(const char *server,
                                       const char * /*share*/,
                                       char *workgroup,
@@ -247,7 +254,9 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
                                       int maxLenPassword)
 {
     //
-    // Authentication
+    // This function is called from the worker thread. The authentication data
+    // was already read on the main thread before the job was started, so that
+    // it only needs to be copied here.
     //
     switch ((*pNetworkItem)->type()) {
     case Network: {
@@ -261,79 +270,151 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
         // Only request authentication data, if the master browsers require
         // authentication data.
         //
-        if (Smb4KSettings::masterBrowsersRequireAuth()) {
-            if (QString::fromUtf8(server, -1).toUpper() != QString::fromUtf8(workgroup, -1).toUpper()) {
-                //
-                // This is the master browser. Create a host object for it.
-                //
-                HostPtr masterBrowser = HostPtr::create();
-                masterBrowser->setWorkgroupName(QString::fromUtf8(workgroup, -1));
-                masterBrowser->setHostName(QString::fromUtf8(server, -1));
+        if (m_masterBrowsersRequireAuth) {
+            QString serverName = QString::fromUtf8(server, -1);
+            QString workgroupName = QString::fromUtf8(workgroup, -1);
 
+            if (serverName.toUpper() != workgroupName.toUpper()) {
                 //
-                // Get the authentication data
+                // This is the master browser. If it is not the one known in advance,
+                // read its authentication data on the main thread. The credentials
+                // manager must not be used from the worker thread. Do not block on
+                // the main thread, because it might be waiting for this thread to
+                // finish. Instead, wait until the data was read or the job was
+                // cancelled.
                 //
-                Smb4KCredentialsManager::self()->readLoginCredentials(masterBrowser);
+                if (QString::compare(serverName, m_masterBrowserName, Qt::CaseInsensitive) != 0) {
+                    if (m_cancelled.loadAcquire() || QCoreApplication::closingDown()) {
+                        break;
+                    }
+
+                    HostPtr masterBrowser = HostPtr::create();
+                    masterBrowser->setWorkgroupName(workgroupName);
+                    masterBrowser->setHostName(serverName);
+
+                    QSharedPointer<QSemaphore> semaphore = QSharedPointer<QSemaphore>::create();
+
+                    QMetaObject::invokeMethod(
+                        Smb4KCredentialsManager::self(),
+                        [masterBrowser, semaphore]() {
+                            Smb4KCredentialsManager::self()->readLoginCredentials(masterBrowser);
+                            semaphore->release();
+                        },
+                        Qt::QueuedConnection);
+
+                    while (!semaphore->tryAcquire(1, 100)) {
+                        if (m_cancelled.loadAcquire()) {
+                            break;
+                        }
+                    }
+
+                    if (m_cancelled.loadAcquire()) {
+                        break;
+                    }
+
+                    m_masterBrowserName = serverName;
+                    m_authUserName = masterBrowser->userName();
+                    m_authPassword = masterBrowser->password();
+                    m_hasAuthData = masterBrowser->hasUserInfo();
+                }
 
                 //
                 // Copy the authentication data
                 //
-                if (masterBrowser->hasUserInfo()) {
-                    qstrncpy(username, masterBrowser->userName().toUtf8().data(), maxLenUsername);
-                    qstrncpy(password, masterBrowser->password().toUtf8().data(), maxLenPassword);
+                if (m_hasAuthData) {
+                    qstrncpy(username, m_authUserName.toUtf8().data(), maxLenUsername);
+                    qstrncpy(password, m_authPassword.toUtf8().data(), maxLenPassword);
                 }
             }
         }
 
         break;
     }
-    case Host: {
+    case Host:
+    case Share:
+    case FileOrDirectory: {
         //
-        // The host object
+        // Copy the authentication data
         //
-        HostPtr host = (*pNetworkItem).staticCast<Smb4KHost>();
+        if (m_hasAuthData) {
+            qstrncpy(username, m_authUserName.toUtf8().data(), maxLenUsername);
+            qstrncpy(password, m_authPassword.toUtf8().data(), maxLenPassword);
+        }
 
-        //
-        // Get the authentication data
-        //
-        Smb4KCredentialsManager::self()->readLoginCredentials(host);
+        break;
+    }
+    default: {
+        break;
+    }
+    }
+}
+
+void Smb4KClientJob::prepareClientLibrary()
+{
+    //
+    // This function is run on the main thread. It collects everything the
+    // worker thread needs from the global lists, the settings and the
+    // credentials manager, because these must not be accessed from there.
+    //
+    m_dnsDiscovered = (*pNetworkItem)->dnsDiscovered();
+    m_masterBrowsersRequireAuth = Smb4KSettings::masterBrowsersRequireAuth();
 
+    //
+    // Get the authentication data
+    //
+    switch ((*pNetworkItem)->type()) {
+    case Workgroup: {
         //
-        // Copy the authentication data
+        // Read the authentication data for the master browser, if it is known
         //
-        if (host->hasUserInfo()) {
-            qstrncpy(username, host->userName().toUtf8().data(), maxLenUsername);
-            qstrncpy(password, host->password().toUtf8().data(), maxLenPassword);
+        WorkgroupPtr workgroup = (*pNetworkItem).staticCast<Smb4KWorkgroup>();
+
+        if (m_masterBrowsersRequireAuth && workgroup->hasMasterBrowser()) {
+            HostPtr masterBrowser = HostPtr::create();
+            masterBrowser->setWorkgroupName(workgroup->workgroupName());
+            masterBrowser->setHostName(workgroup->masterBrowserName());
+
+            Smb4KCredentialsManager::self()->readLoginCredentials(masterBrowser);
+
+            m_masterBrowserName = masterBrowser->hostName();
+            m_authUserName = masterBrowser->userName();
+            m_authPassword = masterBrowser->password();
+            m_hasAuthData = masterBrowser->hasUserInfo();
         }
 
         break;
     }
+    case Host: {
+        HostPtr host = (*pNetworkItem).staticCast<Smb4KHost>();
+        m_workgroupName = host->workgroupName();
+        m_serverAddress.setAddress(host->ipAddress());
+
+        Smb4KCredentialsManager::self()->readLoginCredentials(host);
+
+        m_authUserName = host->userName();
+        m_authPassword = host->password();
+        m_hasAuthData = host->hasUserInfo();
+
+        break;
+    }
     case Share: {
-        //
-        // The share object
-        //
         SharePtr share = (*pNetworkItem).staticCast<Smb4KShare>();
+        m_workgroupName = share->workgroupName();
+        m_serverAddress.setAddress(share->hostIpAddress());
+        m_displayString = share->displayString();
 
-        //
-        // Get the authentication data
-        //
         Smb4KCredentialsManager::self()->readLoginCredentials(share);
 
-        //
-        // Copy the authentication data
-        //
-        if (share->hasUserInfo()) {
-            qstrncpy(username, share->userName().toUtf8().data(), maxLenUsername);
-            qstrncpy(password, share->password().toUtf8().data(), maxLenPassword);
-        }
+        m_authUserName = share->userName();
+        m_authPassword = share->password();
+        m_hasAuthData = share->hasUserInfo();
 
         break;
     }
     case FileOrDirectory: {
-        //
-        // The file object
-        //
         FilePtr file = (*pNetworkItem).staticCast<Smb4KFile>();
+        m_workgroupName = file->workgroupName();
+        m_serverAddress.setAddress(file->hostIpAddress());
 
         if (file->isDirectory()) {
             SharePtr share = SharePtr::create();
@@ -343,18 +424,11 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
             share->setUserName(file->userName());
             share->setPassword(file->password());
 
-            //
-            // Get the authentication data
-            //
             Smb4KCredentialsManager::self()->readLoginCredentials(share);
 
-            //
-            // Copy the authentication data
-            //
-            if (share->hasUserInfo()) {
-                qstrncpy(username, share->userName().toUtf8().data(), maxLenUsername);
-                qstrncpy(password, share->password().toUtf8().data(), maxLenPassword);
-            }
+            m_authUserName = share->userName();
+            m_authPassword = share->password();
+            m_hasAuthData = share->hasUserInfo();
         }
 
         break;
@@ -363,38 +437,8 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
         break;
     }
     }
-}
-
-void Smb4KClientJob::initClientLibrary()
-{
-    //
-    // Get new context
-    //
-    m_context = smbc_new_context();
-
-    if (!m_context) {
-        int errorCode = errno;
-
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
-
-        emitResult();
-        return;
-    }
 
-    //
-    // Init the context
-    //
-    m_context = smbc_init_context(m_context);
-
-    if (!m_context) {
-        int errorCode = errno;
-
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
-        emitResult();
-        return;
-    }
+    m_url = (*pNetworkItem)->url();
 
     //
     // Get the custom options
@@ -402,13 +446,10 @@ void Smb4KClientJob::initClientLibrary()
     CustomSettingsPtr options = Smb4KCustomSettingsManager::self()->findCustomSettings(*pNetworkItem);
 
     //
-    // Set debug level
+    // Determine the NetBIOS name and the workgroup to make connections
     //
-    smbc_setDebug(m_context, SMBC_DEBUG);
+    QString netbiosName, workgroupName;
 
-    //
-    // Set the NetBIOS name and the workgroup to make connections
-    //
     switch ((*pNetworkItem)->type()) {
     case Network: {
         //
@@ -424,7 +465,7 @@ void Smb4KClientJob::initClientLibrary()
         // Only set the NetBIOS name, if the workgroup entry has a master browser
         //
         if (workgroup->hasMasterBrowser()) {
-            smbc_setNetbiosName(m_context, workgroup->masterBrowserName().toUtf8().data());
+            netbiosName = workgroup->masterBrowserName();
         }
 
         //
@@ -433,7 +474,7 @@ void Smb4KClientJob::initClientLibrary()
         // the workgroup if no DNS-SD discovery was used.
         //
         if (!workgroup->dnsDiscovered()) {
-            smbc_setWorkgroup(m_context, workgroup->workgroupName().toUtf8().data());
+            workgroupName = workgroup->workgroupName();
         }
 
         break;
@@ -448,13 +489,13 @@ void Smb4KClientJob::initClientLibrary()
         WorkgroupPtr workgroup = findWorkgroup(host->workgroupName());
 
         if (workgroup && !workgroup->dnsDiscovered()) {
-            smbc_setWorkgroup(m_context, host->workgroupName().toUtf8().data());
+            workgroupName = host->workgroupName();
         }
 
         //
         // Set the NetBIOS name
         //
-        smbc_setNetbiosName(m_context, host->hostName().toUtf8().data());
+        netbiosName = host->hostName();
 
         break;
     }
@@ -468,13 +509,13 @@ void Smb4KClientJob::initClientLibrary()
         WorkgroupPtr workgroup = findWorkgroup(share->workgroupName());
 
         if (workgroup && !workgroup->dnsDiscovered()) {
-            smbc_setWorkgroup(m_context, share->workgroupName().toUtf8().data());
+            workgroupName = share->workgroupName();
         }
 
         //
         // Set the NetBIOS name
         //
-        smbc_setNetbiosName(m_context, share->hostName().toUtf8().data());
+        netbiosName = share->hostName();
 
         break;
     }
@@ -490,13 +531,13 @@ void Smb4KClientJob::initClientLibrary()
             WorkgroupPtr workgroup = findWorkgroup(file->workgroupName());
 
             if (workgroup && !workgroup->dnsDiscovered()) {
-                smbc_setWorkgroup(m_context, file->workgroupName().toUtf8().data());
+                workgroupName = file->workgroupName();
             }
 
             //
             // Set the NetBIOS name
             //
-            smbc_setNetbiosName(m_context, file->hostName().toUtf8().data());
+            netbiosName = file->hostName();
         }
 
         break;
@@ -507,34 +548,20 @@ void Smb4KClientJob::initClientLibrary()
     }
 
     //
-    // Set the user for making the connection
+    // Determine the user for making the connection
     //
     // To be able to connect to a Windows 10 server and get the list
     // of shared resources, use the 'guest' user here, if the URL
     // does not provide a user name.
     //
-    if (!(*pNetworkItem)->url().userName().isEmpty()) {
-        smbc_setUser(m_context, (*pNetworkItem)->url().userName().toUtf8().data());
-    } else {
-        smbc_setUser(m_context, "guest");
-    }
-
-    //
-    // Set the user data (this class)
-    //
-    smbc_setOptionUserData(m_context, this);
+    QString userName = (*pNetworkItem)->url().userName();
 
-    //
-    // Set number of master browsers to be used
-    //
-    if (Smb4KSettings::largeNetworkNeighborhood()) {
-        smbc_setOptionBrowseMaxLmbCount(m_context, 3);
-    } else {
-        smbc_setOptionBrowseMaxLmbCount(m_context, 0 /* all master browsers */);
+    if (userName.isEmpty()) {
+        userName = QStringLiteral("guest");
     }
 
     //
-    // Set the protocol version if desired
+    // Determine the protocol versions if desired
     //
     int minimal = -1;
     int maximal = -1;
@@ -590,27 +617,23 @@ void Smb4KClientJob::initClientLibrary()
         }
     }
 
-    if (!minimalClientProtocolVersionString.isEmpty() && !maximalClientProtocolVersionString.isEmpty()) {
-        smbc_setOptionProtocols(m_context, minimalClientProtocolVersionString.toLatin1().data(), maximalClientProtocolVersionString.toLatin1().data());
-    } else {
-        smbc_setOptionProtocols(m_context, nullptr, nullptr);
-    }
-
     //
-    // Set the encryption level
+    // Determine the encryption level
     //
+    int encryptionLevel = -1;
+
     if (Smb4KSettings::useEncryptionLevel()) {
         switch (Smb4KSettings::encryptionLevel()) {
         case Smb4KSettings::EnumEncryptionLevel::None: {
-            smbc_setOptionSmbEncryptionLevel(m_context, SMBC_ENCRYPTLEVEL_NONE);
+            encryptionLevel = SMBC_ENCRYPTLEVEL_NONE;
             break;
         }
         case Smb4KSettings::EnumEncryptionLevel::Request: {
-            smbc_setOptionSmbEncryptionLevel(m_context, SMBC_ENCRYPTLEVEL_REQUEST);
+            encryptionLevel = SMBC_ENCRYPTLEVEL_REQUEST;
             break;
         }
         case Smb4KSettings::EnumEncryptionLevel::Require: {
-            smbc_setOptionSmbEncryptionLevel(m_context, SMBC_ENCRYPTLEVEL_REQUIRE);
+            encryptionLevel = SMBC_ENCRYPTLEVEL_REQUIRE;
             break;
         }
         default: {
@@ -619,6 +642,147 @@ void Smb4KClientJob::initClientLibrary()
         }
     }
 
+    //
+    // Determine the usage of Kerberos
+    //
+    bool useKerberos = options ? options->useKerberos() : Smb4KSettings::useKerberos();
+
+    //
+    // Compose the key under which the context is kept in the pool. It covers
+    // everything that is fixed for the lifetime of a context. The password is
+    // only included as part of the hash.
+    //
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(workgroupName.toUpper().toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(netbiosName.toUpper().toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(userName.toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData((*pNetworkItem)->url().password().toUtf8());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(minimalClientProtocolVersionString.toLatin1());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(maximalClientProtocolVersionString.toLatin1());
+    hash.addData(QByteArrayView("\n"));
+    hash.addData(QByteArray::number(encryptionLevel));
+    hash.addData(QByteArray::number(useKerberos));
+    hash.addData(QByteArray::number(Smb4KSettings::useWinbindCCache()));
+    hash.addData(QByteArray::number(Smb4KSettings::largeNetworkNeighborhood()));
+    hash.addData(QByteArray::number(m_timeout));
+
+    //
+    // Store the settings for the worker thread
+    //
+    m_contextSettings.key = hash.result();
+    m_contextSettings.netbiosName = netbiosName;
+    m_contextSettings.workgroupName = workgroupName;
+    m_contextSettings.userName = userName;
+    m_contextSettings.minimalProtocolVersion = minimalClientProtocolVersionString;
+    m_contextSettings.maximalProtocolVersion = maximalClientProtocolVersionString;
+    m_contextSettings.encryptionLevel = encryptionLevel;
+    m_contextSettings.useKerberos = useKerberos;
+    m_contextSettings.useCCache = Smb4KSettings::useWinbindCCache();
+    m_contextSettings.largeNetworkNeighborhood = Smb4KSettings::largeNetworkNeighborhood();
+}
+
+bool Smb4KClientJob::initClientLibrary()
+{
+    //
+    // Reuse an already initialized context if possible
+    //
+    m_context = Smb4KClientContextPool::self()->acquire(m_contextSettings.key);
+
+    if (m_context) {
+        smbc_setOptionUserData(m_context, this);
+        return true;
+    }
+
+    //
+    // Get new context
+    //
+    SMBCCTX *context = smbc_new_context();
+
+    if (!context) {
+        int errorCode = errno;
+        reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
+        return false;
+    }
+
+    //
+    // Init the context
+    //
+    m_context = smbc_init_context(context);
+
+    if (!m_context) {
+        int errorCode = errno;
+
+        smbc_free_context(context, 0);
+
+        reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
+        return false;
+    }
+
+    //
+    // Set debug level
+    //
+    smbc_setDebug(m_context, SMBC_DEBUG);
+
+    //
+    // Set the NetBIOS name and the workgroup to make connections
+    //
+    if (!m_contextSettings.netbiosName.isEmpty()) {
+        smbc_setNetbiosName(m_context, m_contextSettings.netbiosName.toUtf8().data());
+    }
+
+    if (!m_contextSettings.workgroupName.isEmpty()) {
+        smbc_setWorkgroup(m_context, m_contextSettings.workgroupName.toUtf8().data());
+    }
+
+    //
+    // Set the user for making the connection
+    //
+    smbc_setUser(m_context, m_contextSettings.userName.toUtf8().data());
+
+    //
+    // Set the user data (this class)
+    //
+    smbc_setOptionUserData(m_context, this);
+
+    //
+    // Set number of master browsers to be used
+    //
+    if (m_contextSettings.largeNetworkNeighborhood) {
+        smbc_setOptionBrowseMaxLmbCount(m_context, 3);
+    } else {
+        smbc_setOptionBrowseMaxLmbCount(m_context, 0 /* all master browsers */);
+    }
+
+    //
+    // Set the protocol version if desired
+    //
+    if (!m_contextSettings.minimalProtocolVersion.isEmpty() && !m_contextSettings.maximalProtocolVersion.isEmpty()) {
+        smbc_setOptionProtocols(m_context,
+                                m_contextSettings.minimalProtocolVersion.toLatin1().data(),
+                                m_contextSettings.maximalProtocolVersion.toLatin1().data());
+    } else {
+        smbc_setOptionProtocols(m_context, nullptr, nullptr);
+    }
+
+    //
+    // Set the encryption level
+    //
+    if (m_contextSettings.encryptionLevel != -1) {
+        smbc_setOptionSmbEncryptionLevel(m_context, static_cast<smbc_smb_encrypt_level>(m_contextSettings.encryptionLevel));
+    }
+
+    //
+    // Set the timeout if desired
+    //
+    if (m_timeout > 0) {
+        smbc_setTimeout(m_context, m_timeout);
+    }
+
     //
     // Set the usage of anonymous login
     //
@@ -627,17 +791,12 @@ void Smb4KClientJob::initClientLibrary()
     //
     // Set the usage of the winbind ccache
     //
-    smbc_setOptionUseCCache(m_context, Smb4KSettings::useWinbindCCache());
+    smbc_setOptionUseCCache(m_context, m_contextSettings.useCCache);
 
     //
     // Set usage of Kerberos
     //
-    if (options) {
-        smbc_setOptionUseKerberos(m_context, options->useKerberos());
-    } else {
-        smbc_setOptionUseKerberos(m_context, Smb4KSettings::useKerberos());
-    }
-
+    smbc_setOptionUseKerberos(m_context, m_contextSettings.useKerberos);
     smbc_setOptionFallbackAfterKerberos(m_context, 1);
 
     //
@@ -649,15 +808,17 @@ void Smb4KClientJob::initClientLibrary()
     // Set auth callback function
     //
     smbc_setFunctionAuthDataWithContext(m_context, get_auth_data_with_context_fn);
-}
 
-void Smb4KClientJob::doLookups()
-{
     //
-    // Set the new context
+    // Register the context with the pool
     //
-    (void)smbc_set_context(m_context);
+    Smb4KClientContextPool::self()->insert(m_contextSettings.key, m_context);
 
+    return true;
+}
+
+void Smb4KClientJob::doLookups()
+{
     //
     // Get the function to open the directory.
     //
@@ -665,8 +826,7 @@ void Smb4KClientJob::doLookups()
 
     if (!openDirectory) {
         int errorCode = errno;
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+        reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
         return;
     }
 
@@ -678,29 +838,26 @@ void Smb4KClientJob::doLookups()
     // to stop here in that case, do not throw an error when using DNS-SD and
     // Network and Workgroup (parent) items.
     //
-    SMBCFILE *directory = openDirectory(m_context, (*pNetworkItem)->url().toString().toUtf8().data());
+    SMBCFILE *directory = openDirectory(m_context, m_url.toString().toUtf8().data());
 
     if (!directory) {
-        if (!(*pNetworkItem)->dnsDiscovered() && !((*pNetworkItem)->type() == Network || (*pNetworkItem)->type() == Workgroup)) {
+        if (!m_dnsDiscovered && !((*pNetworkItem)->type() == Network || (*pNetworkItem)->type() == Workgroup)) {
             int errorCode = errno;
 
             switch (errorCode) {
             case EACCES:
             case EPERM: {
-                setError(AccessDeniedError);
-                setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+                reportError(AccessDeniedError, QString::fromUtf8(strerror(errorCode), -1));
                 break;
             }
             case ENOENT: {
                 if ((*pNetworkItem)->type() != Network) {
-                    setError(ClientError);
-                    setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+                    reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
                 }
                 break;
             }
             default: {
-                setError(ClientError);
-                setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+                reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
                 break;
             }
             }
@@ -717,11 +874,67 @@ void Smb4KClientJob::doLookups()
 
     if (!readDirectory) {
         int errorCode = errno;
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+        reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
         return;
     }
 
+    //
+    // The IP address of the server that is queried. Since all shares, files and
+    // directories belong to the same server, it is only determined once per job.
+    //
+    QHostAddress serverAddress = m_serverAddress;
+    bool serverAddressKnown = false;
+
+    auto lookupServerAddress = [&]() {
+        if (!serverAddressKnown) {
+            if (serverAddress.isNull()) {
+                serverAddress = Smb4KResolver::self()->lookupIpAddress(m_url.host());
+            }
+
+            serverAddressKnown = true;
+        }
+
+        return serverAddress;
+    };
+
+    //
+    // Pass the discovered shares, files and directories to the main thread in
+    // batches while the enumeration continues, so that large servers and
+    // directories can be shown before the listing is complete.
+    //
+    qsizetype publishedShares = 0;
+    qsizetype publishedFiles = 0;
+    QElapsedTimer batchTimer;
+    batchTimer.start();
+
+    auto publishBatch = [&]() {
+        if (pShares->size() > publishedShares) {
+            QList<SharePtr> batch = pShares->mid(publishedShares);
+            publishedShares = pShares->size();
+
+            QMetaObject::invokeMethod(
+                this,
+                [this, batch]() {
+                    Q_EMIT sharesDiscovered(batch);
+                },
+                Qt::QueuedConnection);
+        }
+
+        if (pFiles->size() > publishedFiles) {
+            QList<FilePtr> batch = pFiles->mid(publishedFiles);
+            publishedFiles = pFiles->size();
+
+            QMetaObject::invokeMethod(
+                this,
+                [this, batch]() {
+                    Q_EMIT filesDiscovered(batch);
+                },
+                Qt::QueuedConnection);
+        }
+
+        batchTimer.restart();
+    };
+
     while ((directoryEntry = readDirectory(m_context, directory)) != nullptr) {
         switch (directoryEntry->smbc_type) {
         case SMBC_WORKGROUP: {
@@ -743,21 +956,10 @@ void Smb4KClientJob::doLookups()
             workgroup->setMasterBrowserName(masterBrowserName);
 
             //
-            // Lookup IP address
-            //
-            QHostAddress address = lookupIpAddress(masterBrowserName);
-
+            // Add the workgroup. The IP address of the master browser is looked up
+            // asynchronously by Smb4KClient after the workgroup has been published.
             //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip the
-            // workgroup and delete the pointer.
-            //
-            if (!address.isNull()) {
-                workgroup->setMasterBrowserIpAddress(address);
-                *pWorkgroups << workgroup;
-            } else {
-                workgroup.clear();
-            }
+            *pWorkgroups << workgroup;
 
             break;
         }
@@ -770,7 +972,7 @@ void Smb4KClientJob::doLookups()
             //
             // Set the workgroup name
             //
-            host->setWorkgroupName((*pNetworkItem)->url().host());
+            host->setWorkgroupName(m_url.host());
 
             //
             // Set the host name
@@ -785,21 +987,10 @@ void Smb4KClientJob::doLookups()
             host->setComment(comment);
 
             //
-            // Lookup IP address
+            // Add the host. Its IP address is looked up asynchronously by Smb4KClient
+            // after the host has been published.
             //
-            QHostAddress address = lookupIpAddress(hostName);
-
-            //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip it
-            // and delete the pointer.
-            //
-            if (!address.isNull()) {
-                host->setIpAddress(address);
-                *pHosts << host;
-            } else {
-                host.clear();
-            }
+            *pHosts << host;
 
             break;
         }
@@ -812,12 +1003,12 @@ void Smb4KClientJob::doLookups()
             //
             // Set the workgroup name
             //
-            share->setWorkgroupName((*pNetworkItem).staticCast<Smb4KHost>()->workgroupName());
+            share->setWorkgroupName(m_workgroupName);
 
             //
             // Set the host name
             //
-            share->setHostName((*pNetworkItem)->url().host());
+            share->setHostName(m_url.host());
 
             //
             // Set the share name
@@ -837,13 +1028,13 @@ void Smb4KClientJob::doLookups()
             //
             // Set the authentication data
             //
-            share->setUserName((*pNetworkItem)->url().userName());
-            share->setPassword((*pNetworkItem)->url().password());
+            share->setUserName(m_url.userName());
+            share->setPassword(m_url.password());
 
             //
             // Lookup IP address
             //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+            QHostAddress address = lookupServerAddress();
 
             //
             // Process the IP address.
@@ -868,12 +1059,12 @@ void Smb4KClientJob::doLookups()
             //
             // Set the workgroup name
             //
-            share->setWorkgroupName((*pNetworkItem).staticCast<Smb4KHost>()->workgroupName());
+            share->setWorkgroupName(m_workgroupName);
 
             //
             // Set the host name
             //
-            share->setHostName((*pNetworkItem)->url().host());
+            share->setHostName(m_url.host());
 
             //
             // Set the share name
@@ -893,13 +1084,13 @@ void Smb4KClientJob::doLookups()
             //
             // Set the authentication data
             //
-            share->setUserName((*pNetworkItem)->url().userName());
-            share->setPassword((*pNetworkItem)->url().password());
+            share->setUserName(m_url.userName());
+            share->setPassword(m_url.password());
 
             //
             // Lookup IP address
             //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+            QHostAddress address = lookupServerAddress();
 
             //
             // Process the IP address.
@@ -924,12 +1115,12 @@ void Smb4KClientJob::doLookups()
             //
             // Set the workgroup name
             //
-            share->setWorkgroupName((*pNetworkItem).staticCast<Smb4KHost>()->workgroupName());
+            share->setWorkgroupName(m_workgroupName);
 
             //
             // Set the host name
             //
-            share->setHostName((*pNetworkItem)->url().host());
+            share->setHostName(m_url.host());
 
             //
             // Set the share name
@@ -949,13 +1140,13 @@ void Smb4KClientJob::doLookups()
             //
             // Set the authentication data
             //
-            share->setUserName((*pNetworkItem)->url().userName());
-            share->setPassword((*pNetworkItem)->url().password());
+            share->setUserName(m_url.userName());
+            share->setPassword(m_url.password());
 
             //
             // Lookup IP address
             //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+            QHostAddress address = lookupServerAddress();
 
             //
             // Process the IP address.
@@ -981,8 +1172,8 @@ void Smb4KClientJob::doLookups()
                 //
                 // Create the URL for the discovered item
                 //
-                QUrl u = (*pNetworkItem)->url();
-                u.setPath((*pNetworkItem)->url().path() + QDir::separator() + QString::fromUtf8(directoryEntry->name, -1));
+                QUrl u = m_url;
+                u.setPath(m_url.path() + QDir::separator() + QString::fromUtf8(directoryEntry->name, -1));
 
                 //
                 // We do not stat directories. Directly create the directory object
@@ -993,18 +1184,18 @@ void Smb4KClientJob::doLookups()
                 //
                 // Set the workgroup name
                 //
-                dir->setWorkgroupName((*pNetworkItem).staticCast<Smb4KShare>()->workgroupName());
+                dir->setWorkgroupName(m_workgroupName);
 
                 //
                 // Set the authentication data
                 //
-                dir->setUserName((*pNetworkItem)->url().userName());
-                dir->setPassword((*pNetworkItem)->url().password());
+                dir->setUserName(m_url.userName());
+                dir->setPassword(m_url.password());
 
                 //
                 // Lookup IP address
                 //
-                QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+                QHostAddress address = lookupServerAddress();
 
                 //
                 // Process the IP address.
@@ -1025,8 +1216,8 @@ void Smb4KClientJob::doLookups()
             //
             // Create the URL for the discovered item
             //
-            QUrl u = (*pNetworkItem)->url();
-            u.setPath((*pNetworkItem)->url().path() + QDir::separator() + QString::fromUtf8(directoryEntry->name, -1));
+            QUrl u = m_url;
+            u.setPath(m_url.path() + QDir::separator() + QString::fromUtf8(directoryEntry->name, -1));
 
             //
             // Create the file object
@@ -1036,7 +1227,7 @@ void Smb4KClientJob::doLookups()
             //
             // Set the workgroup name
             //
-            file->setWorkgroupName((*pNetworkItem).staticCast<Smb4KShare>()->workgroupName());
+            file->setWorkgroupName(m_workgroupName);
 
             //
             // Stat the file
@@ -1046,13 +1237,13 @@ void Smb4KClientJob::doLookups()
             //
             // Set the authentication data
             //
-            file->setUserName((*pNetworkItem)->url().userName());
-            file->setPassword((*pNetworkItem)->url().password());
+            file->setUserName(m_url.userName());
+            file->setPassword(m_url.password());
 
             //
             // Lookup IP address
             //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+            QHostAddress address = lookupServerAddress();
 
             //
             // Process the IP address.
@@ -1079,6 +1270,27 @@ void Smb4KClientJob::doLookups()
             break;
         }
         }
+
+        if ((pShares->size() - publishedShares) + (pFiles->size() - publishedFiles) >= STREAMING_BATCH_SIZE
+            || batchTimer.hasExpired(STREAMING_BATCH_INTERVAL)) {
+            publishBatch();
+        }
+
+        //
+        // Stop when the job was killed
+        //
+        if (m_cancelled.loadAcquire()) {
+            break;
+        }
+
+        //
+        // Give up on a server that does not finish in time, even if it answers
+        // each single request before the timeout of libsmbclient
+        //
+        if (m_deadline.hasExpired()) {
+            reportError(ClientError, i18n("The server %1 did not respond in time.", m_url.host()));
+            break;
+        }
     }
 
     //
@@ -1088,32 +1300,18 @@ void Smb4KClientJob::doLookups()
 
     if (!closeDirectory) {
         int errorCode = errno;
-
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+        reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
         return;
     }
 
     (void)closeDirectory(m_context, directory);
 }
 
-void Smb4KClientJob::doPrinting()
+bool Smb4KClientJob::preparePrinting()
 {
     //
-    // Set the new context
-    //
-    (void)smbc_set_context(m_context);
-
-    //
-    // The URL that is to be printed
-    //
-    QUrl fileUrl;
-
-    //
-    // Set the temporary directory
-    //
-    QTemporaryDir tempDir;
-
+    // This function is run on the main thread, because the conversion
+    // of the file uses QPrinter and QTextDocument.
     //
     // Check if we can directly print the file
     //
@@ -1122,16 +1320,22 @@ void Smb4KClientJob::doPrinting()
         //
         // Set the URL to the incoming file
         //
-        fileUrl = m_fileItem.url();
+        m_printFileUrl = m_fileItem.url();
     } else if (m_fileItem.mimetype() == QStringLiteral("application/x-shellscript") || m_fileItem.mimetype().startsWith(QStringLiteral("text"))
                || m_fileItem.mimetype().startsWith(QStringLiteral("message"))) {
+        //
+        // Set the temporary directory. It has to exist until the file was
+        // printed, so it is removed when the job is destroyed.
+        //
+        m_tempDir = new QTemporaryDir();
+
         //
         // Set a printer object
         //
         QPrinter printer(QPrinter::HighResolution);
         printer.setCreator(QStringLiteral("Smb4K"));
         printer.setOutputFormat(QPrinter::PdfFormat);
-        printer.setOutputFileName(tempDir.path() + QDir::separator() + QStringLiteral("smb4k_print.pdf"));
+        printer.setOutputFileName(m_tempDir->path() + QDir::separator() + QStringLiteral("smb4k_print.pdf"));
 
         //
         // Open the file that is to be printed and read it
@@ -1147,7 +1351,7 @@ void Smb4KClientJob::doPrinting()
                 contents << ts.readLine();
             }
         } else {
-            return;
+            return false;
         }
 
         //
@@ -1166,13 +1370,18 @@ void Smb4KClientJob::doPrinting()
         //
         // Set the URL to the converted file
         //
-        fileUrl.setUrl(printer.outputFileName());
-        fileUrl.setScheme(QStringLiteral("file"));
+        m_printFileUrl.setUrl(printer.outputFileName());
+        m_printFileUrl.setScheme(QStringLiteral("file"));
     } else {
         Smb4KNotification::mimetypeNotSupported(m_fileItem.mimetype());
-        return;
+        return false;
     }
 
+    return true;
+}
+
+void Smb4KClientJob::doPrinting()
+{
     //
     // Get the open function for the printer
     //
@@ -1180,28 +1389,25 @@ void Smb4KClientJob::doPrinting()
 
     if (!openPrinter) {
         int errorCode = errno;
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+        reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
         return;
     }
 
     //
     // Open the printer for printing
     //
-    SMBCFILE *printer = openPrinter(m_context, (*pNetworkItem)->url().toString().toUtf8().data());
+    SMBCFILE *printer = openPrinter(m_context, m_url.toString().toUtf8().data());
 
     if (!printer) {
         int errorCode = errno;
 
         switch (errorCode) {
         case EACCES: {
-            setError(AccessDeniedError);
-            setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+            reportError(AccessDeniedError, QString::fromUtf8(strerror(errorCode), -1));
             break;
         }
         default: {
-            setError(ClientError);
-            setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+            reportError(ClientError, QString::fromUtf8(strerror(errorCode), -1));
             break;
         }
         }
@@ -1212,11 +1418,10 @@ void Smb4KClientJob::doPrinting()
     //
     // Open the file
     //
-    QFile file(fileUrl.path());
+    QFile file(m_printFileUrl.path());
 
     if (!file.open(QFile::ReadOnly)) {
-        setError(FileAccessError);
-        setErrorText(i18n("The file %1 could not be read", fileUrl.path()));
+        reportError(FileAccessError, i18n("The file %1 could not be read", m_printFileUrl.path()));
         return;
     }
 
@@ -1232,8 +1437,7 @@ void Smb4KClientJob::doPrinting()
             smbc_write_fn writeFile = smbc_getFunctionWrite(m_context);
 
             if (writeFile(m_context, printer, buffer, bytes) < 0) {
-                setError(PrintFileError);
-                setErrorText(i18n("The file %1 could not be printed to %2", fileUrl.path(), (*pNetworkItem).staticCast<Smb4KShare>()->displayString()));
+                reportError(PrintFileError, i18n("The file %1 could not be printed to %2", m_printFileUrl.path(), m_displayString));
 
                 smbc_close_fn closePrinter = smbc_getFunctionClose(m_context);
                 closePrinter(m_context, printer);
@@ -1250,37 +1454,95 @@ void Smb4KClientJob::doPrinting()
     closePrinter(m_context, printer);
 }
 
-void Smb4KClientJob::slotStartJob()
+void Smb4KClientJob::reportError(int errorCode, const QString &errorText)
 {
     //
-    // Initialize the client library
+    // KJob is not thread-safe. The error is passed to it on the main
+    // thread in slotFinishWork().
     //
-    initClientLibrary();
+    m_errorCode = errorCode;
+    m_errorText = errorText;
+}
 
+void Smb4KClientJob::doWork()
+{
     //
-    // Process the given URL according to the passed process
+    // This function is run in the worker thread.
     //
-    switch (*pProcess) {
-    case LookupDomains:
-    case LookupDomainMembers:
-    case LookupShares:
-    case LookupFiles: {
-        //
-        // Do lookups using the client library
-        //
-        doLookups();
-        break;
-    }
-    case PrintFile: {
+    // The deadline starts when the work begins and not when the job was
+    // queued
+    //
+    m_deadline = m_timeout > 0 ? QDeadlineTimer(m_timeout) : QDeadlineTimer(QDeadlineTimer::Forever);
+
+    //
+    // Initialize the client library
+    //
+    if (!m_cancelled.loadAcquire() && initClientLibrary()) {
         //
-        // Print files using the client library
+        // Process the given URL according to the passed process
         //
-        doPrinting();
-        break;
+        switch (*pProcess) {
+        case LookupDomains:
+        case LookupDomainMembers:
+        case LookupShares:
+        case LookupFiles: {
+            //
+            // Do lookups using the client library
+            //
+            doLookups();
+            break;
+        }
+        case PrintFile: {
+            //
+            // Print files using the client library
+            //
+            doPrinting();
+            break;
+        }
+        default: {
+            break;
+        }
+        }
     }
-    default: {
-        break;
+
+    //
+    // Return to the main thread
+    //
+    QMetaObject::invokeMethod(this, &Smb4KClientJob::slotFinishWork, Qt::QueuedConnection);
+}
+
+void Smb4KClientJob::slotStartJob()
+{
+    //
+    // Collect the data that can only be accessed from the main thread
+    //
+    prepareClientLibrary();
+
+    if (*pProcess == PrintFile && !preparePrinting()) {
+        emitResult();
+        return;
     }
+
+    //
+    // Run the blocking calls to libsmbclient in a worker thread
+    //
+    m_working = true;
+
+    QThreadPool *threadPool = m_threadPool ? m_threadPool : QThreadPool::globalInstance();
+    threadPool->start([this]() {
+        doWork();
+    });
+}
+
+void Smb4KClientJob::slotFinishWork()
+{
+    m_working = false;
+
+    if (m_cancelled.loadAcquire()) {
+        setError(KilledJobError);
+    } else if (m_errorCode != NoError) {
+        setError(m_errorCode);
+        setErrorText(m_errorText);
     }
 
     //
@@ -1292,7 +1554,13 @@ void Smb4KClientJob::slotStartJob()
 void Smb4KClientJob::slotFinishJob()
 {
     if (m_context != nullptr) {
-        smbc_free_context(m_context, 1);
+        //
+        // Only contexts that did not run into a communication problem
+        // are reused. Access denied errors are fine, because the
+        // credentials are looked up again by the auth callback.
+        //
+        Smb4KClientContextPool::self()->release(m_context, error() == NoError || error() == AccessDeniedError);
+        m_context = nullptr;
     }
 }
 
@@ -1428,18 +1696,6 @@ void Smb4KDnsDiscoveryJob::slotServiceAdded(KDNSSD::RemoteService::Ptr service)
             //
             host->setDnsDiscovered(true);
 
-            //
-            // Lookup IP address
-            //
-            QHostAddress address = lookupIpAddress(service->serviceName());
-
-            //
-            // Process the IP address.
-            //
-            if (!address.isNull()) {
-                host->setIpAddress(address);
-            }
-
             //
             // Add the host
             //
@@ -1668,18 +1924,6 @@ void Smb4KWsDiscoveryJob::slotProbeMatchReceived(const WSDiscoveryTargetService
                                     //
                                     host->setHostName(hostName);
 
-                                    //
-                                    // Lookup IP address
-                                    //
-                                    QHostAddress address = lookupIpAddress(hostName);
-
-                                    //
-                                    // Process the IP address.
-                                    //
-                                    if (!address.isNull()) {
-                                        host->setIpAddress(address);
-                                    }
-
                                     //
                                     // Add the host
                                     //
@@ -1862,18 +2106,6 @@ void Smb4KWsDiscoveryJob::slotResolveMatchReceived(const WSDiscoveryTargetServic
                                 //
                                 host->setHostName(hostName);
 
-                                //
-                                // Lookup IP address
-                                //
-                                QHostAddress address = lookupIpAddress(hostName);
-
-                                //
-                                // Process the IP address.
-                                //
-                                if (!address.isNull()) {
-                                    host->setIpAddress(address);
-                                }
-
                                 //
                                 // Add the host
                                 //
@@ -1903,3 +2135,145 @@ void Smb4KWsDiscoveryJob::slotDiscoveryFinished()
     emitResult();
 }
 #endif
+
+//
+// Context pool
+//
+Smb4KClientContextPool::Smb4KClientContextPool(QObject *parent)
+    : QObject(parent)
+{
+    m_evictionTimer.setInterval(CONTEXT_POOL_IDLE_TIMEOUT / 2);
+    connect(&m_evictionTimer, &QTimer::timeout, this, &Smb4KClientContextPool::slotEvictIdleContexts);
+    m_evictionTimer.start();
+}
+
+Smb4KClientContextPool::~Smb4KClientContextPool()
+{
+    while (!m_idleContexts.isEmpty()) {
+        smbc_free_context(m_idleContexts.takeFirst().context, 1);
+    }
+}
+
+Smb4KClientContextPool *Smb4KClientContextPool::self()
+{
+    return &pool->instance;
+}
+
+SMBCCTX *Smb4KClientContextPool::acquire(const QByteArray &key)
+{
+    QMutexLocker locker(&m_mutex);
+
+    //
+    // Use the most recently released context first, because its
+    // connections are the least likely to have been dropped by the
+    // server.
+    //
+    for (int i = m_idleContexts.size() - 1; i >= 0; --i) {
+        if (m_idleContexts.at(i).key == key) {
+            Entry entry = m_idleContexts.takeAt(i);
+            m_busyContexts.insert(entry.context, entry.key);
+            return entry.context;
+        }
+    }
+
+    return nullptr;
+}
+
+void Smb4KClientContextPool::insert(const QByteArray &key, SMBCCTX *context)
+{
+    QMutexLocker locker(&m_mutex);
+    m_busyContexts.insert(context, key);
+}
+
+void Smb4KClientContextPool::release(SMBCCTX *context, bool reusable)
+{
+    QList<SMBCCTX *> obsoleteContexts;
+
+    m_mutex.lock();
+
+    //
+    // The context was either not registered or the pool was cleared while
+    // it was in use. In both cases it must not be reused.
+    //
+    if (!m_busyContexts.contains(context)) {
+        reusable = false;
+    }
+
+    QByteArray key = m_busyContexts.take(context);
+
+    if (reusable) {
+        //
+        // Do not call back into a job that does not exist anymore
+        //
+        smbc_setOptionUserData(context, nullptr);
+
+        Entry entry;
+        entry.key = key;
+        entry.context = context;
+        entry.idleTimer.start();
+
+        m_idleContexts << entry;
+
+        //
+        // Cap the size of the pool. The least recently used contexts are
+        // at the beginning of the list.
+        //
+        while (m_idleContexts.size() > CONTEXT_POOL_MAX_SIZE) {
+            obsoleteContexts << m_idleContexts.takeFirst().context;
+        }
+    } else {
+        obsoleteContexts << context;
+    }
+
+    m_mutex.unlock();
+
+    for (SMBCCTX *c : std::as_const(obsoleteContexts)) {
+        smbc_free_context(c, 1);
+    }
+}
+
+void Smb4KClientContextPool::clear()
+{
+    QList<SMBCCTX *> obsoleteContexts;
+
+    m_mutex.lock();
+
+    while (!m_idleContexts.isEmpty()) {
+        obsoleteContexts << m_idleContexts.takeFirst().context;
+    }
+
+    //
+    // Contexts that are currently in use are freed when they are released
+    //
+    m_busyContexts.clear();
+
+    m_mutex.unlock();
+
+    for (SMBCCTX *c : std::as_const(obsoleteContexts)) {
+        smbc_free_context(c, 1);
+    }
+}
+
+void Smb4KClientContextPool::slotEvictIdleContexts()
+{
+    QList<SMBCCTX *> obsoleteContexts;
+
+    m_mutex.lock();
+
+    QMutableListIterator<Entry> it(m_idleContexts);
+
+    while (it.hasNext()) {
+        Entry &entry = it.next();
+
+        if (entry.idleTimer.hasExpired(CONTEXT_POOL_IDLE_TIMEOUT)) {
+            obsoleteContexts << entry.context;
+            it.remove();
+        }
+    }
+
+    m_mutex.unlock();
+
+    for (SMBCCTX *c : std::as_const(obsoleteContexts)) {
+        smbc_free_context(c, 1);
+    }
+}
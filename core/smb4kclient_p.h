@@ -20,7 +20,15 @@
 #include <libsmbclient.h>
 
 // Qt includes
+#include <QAtomicInt>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QHostAddress>
+#include <QMutex>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUdpSocket>
 #include <QUrl>
@@ -104,6 +112,23 @@ public:
         PrintFileError
     };
 
+Q_SIGNALS:
+    /**
+     * Emitted while the job is running with a batch of newly discovered shares.
+     * The shares are also part of the list returned by shares().
+     *
+     * @param list          The list of new shares
+     */
+    void sharesDiscovered(const QList<SharePtr> &list);
+
+    /**
+     * Emitted while the job is running with a batch of newly discovered files
+     * and directories. They are also part of the list returned by files().
+     *
+     * @param list          The list of new files and directories
+     */
+    void filesDiscovered(const QList<FilePtr> &list);
+
 protected:
     Smb4KGlobal::Process *pProcess;
     NetworkItemPtr *pNetworkItem;
@@ -111,7 +136,6 @@ protected:
     QList<HostPtr> *pHosts;
     QList<SharePtr> *pShares;
     QList<FilePtr> *pFiles;
-    QHostAddress lookupIpAddress(const QString &name);
 
 private:
     Smb4KGlobal::Process m_process;
@@ -163,7 +187,45 @@ public:
     int printCopies() const;
 
     /**
-     * The authentication function for libsmbclient
+     * Set the timeout in milliseconds after which the job gives up on the
+     * server. It is used as the timeout of each request to libsmbclient and
+     * as the deadline of the whole lookup. If @p timeout is 0, the library's
+     * default is used and the lookup has no deadline.
+     */
+    void setTimeout(int timeout);
+
+    /**
+     * Get the timeout in milliseconds
+     */
+    int timeout() const;
+
+    /**
+     * Mark this job as part of a network search. Errors of such jobs
+     * are not reported to the user.
+     */
+    void setSearchJob(bool search);
+
+    /**
+     * Returns TRUE if this job is part of a network search
+     */
+    bool isSearchJob() const;
+
+    /**
+     * Set the thread pool the blocking work of this job is run in. If no
+     * thread pool is set, the global thread pool is used.
+     */
+    void setThreadPool(QThreadPool *pool);
+
+    /**
+     * Cancel the requests the worker thread is waiting for on the main
+     * thread. This function has to be called before the main thread waits
+     * for the worker threads to finish.
+     */
+    void cancel();
+
+    /**
+     * The authentication function for libsmbclient. It is called from the
+     * worker thread.
      */
     void get_auth_data_fn(const char *server,
                           const char *share,
@@ -174,17 +236,62 @@ public:
                           char *password,
                           int maxLenPassword);
 
+protected:
+    /**
+     * Kill the job. If the worker thread is running, it is asked to stop and
+     * the result is emitted when it returned.
+     */
+    bool doKill() override;
+
 protected Q_SLOTS:
     void slotStartJob();
+    void slotFinishWork();
     void slotFinishJob();
 
 private:
-    void initClientLibrary();
+    struct ContextSettings {
+        QByteArray key;
+        QString netbiosName;
+        QString workgroupName;
+        QString userName;
+        QString minimalProtocolVersion;
+        QString maximalProtocolVersion;
+        int encryptionLevel;
+        bool useKerberos;
+        bool useCCache;
+        bool largeNetworkNeighborhood;
+    };
+    void prepareClientLibrary();
+    bool preparePrinting();
+    void reportError(int errorCode, const QString &errorText);
+    void doWork();
+    bool initClientLibrary();
     void doLookups();
     void doPrinting();
     SMBCCTX *m_context;
     KFileItem m_fileItem;
     int m_copies;
+    int m_timeout;
+    bool m_searchJob;
+    QDeadlineTimer m_deadline;
+    QThreadPool *m_threadPool;
+    QAtomicInt m_cancelled;
+    bool m_working;
+    ContextSettings m_contextSettings;
+    QUrl m_url;
+    QString m_workgroupName;
+    QString m_displayString;
+    QHostAddress m_serverAddress;
+    bool m_dnsDiscovered;
+    bool m_masterBrowsersRequireAuth;
+    QString m_masterBrowserName;
+    QString m_authUserName;
+    QString m_authPassword;
+    bool m_hasAuthData;
+    QUrl m_printFileUrl;
+    QTemporaryDir *m_tempDir;
+    int m_errorCode;
+    QString m_errorText;
 };
 
 class Smb4KDnsDiscoveryJob : public Smb4KClientBaseJob
@@ -249,6 +356,124 @@ private:
 };
 #endif
 
+class Smb4KClientContextPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     */
+    explicit Smb4KClientContextPool(QObject *parent = nullptr);
+
+    /**
+     * Destructor
+     */
+    ~Smb4KClientContextPool();
+
+    /**
+     * Returns a static pointer to this class
+     */
+    static Smb4KClientContextPool *self();
+
+    /**
+     * Take an idle context out of the pool that was set up with the
+     * settings described by @p key. If there is none, a null pointer
+     * is returned.
+     *
+     * @param key           The key describing the context's settings
+     *
+     * @returns an initialized context or NULL.
+     */
+    SMBCCTX *acquire(const QByteArray &key);
+
+    /**
+     * Register a newly created context under the key @p key. The context
+     * is regarded as being in use until it is released.
+     *
+     * @param key           The key describing the context's settings
+     *
+     * @param context       The context
+     */
+    void insert(const QByteArray &key, SMBCCTX *context);
+
+    /**
+     * Give a context back to the pool. If @p reusable is FALSE or the pool
+     * was cleared while the context was in use, the context is freed.
+     *
+     * @param context       The context
+     *
+     * @param reusable      TRUE if the context may be used again
+     */
+    void release(SMBCCTX *context, bool reusable);
+
+    /**
+     * Free all idle contexts and mark the ones in use for disposal
+     */
+    void clear();
+
+protected Q_SLOTS:
+    /**
+     * Free the contexts that were idle for too long
+     */
+    void slotEvictIdleContexts();
+
+private:
+    struct Entry {
+        QByteArray key;
+        SMBCCTX *context;
+        QElapsedTimer idleTimer;
+    };
+    QList<Entry> m_idleContexts;
+    QHash<SMBCCTX *, QByteArray> m_busyContexts;
+    QMutex m_mutex;
+    QTimer m_evictionTimer;
+};
+
+class Smb4KClientContextPoolStatic
+{
+public:
+    Smb4KClientContextPool instance;
+};
+
+template<class T>
+class Smb4KClientDelta
+{
+public:
+    /**
+     * The items that were added to the global list
+     */
+    QList<QSharedPointer<T>> added;
+
+    /**
+     * The items that were removed from the global list
+     */
+    QList<QSharedPointer<T>> removed;
+
+    /**
+     * The items in the global list that were changed
+     */
+    QList<QSharedPointer<T>> changed;
+
+    /**
+     * Returns TRUE if nothing was added, removed or changed
+     */
+    bool isEmpty() const
+    {
+        return added.isEmpty() && removed.isEmpty() && changed.isEmpty();
+    }
+
+    /**
+     * Clear the delta
+     */
+    void clear()
+    {
+        added.clear();
+        removed.clear();
+        changed.clear();
+    }
+};
+
 class Smb4KClientPrivate
 {
 public:
@@ -259,9 +484,24 @@ public:
         int printCopies;
     };
     QList<WorkgroupPtr> tempWorkgroupList;
-    QList<HostPtr> tempHostList;
+    QMap<QString, QList<HostPtr>> tempHostLists;
     QList<QueueContainer> queue;
     QUdpSocket udpSocket;
+    QMultiHash<QString, HostPtr> pendingLookups;
+    QList<WorkgroupPtr> resolvedWorkgroups;
+    Smb4KClientDelta<Smb4KWorkgroup> resolvedWorkgroupsDelta;
+    QMap<QString, Smb4KClientDelta<Smb4KHost>> resolvedHostsDeltas;
+    QTimer resolverTimer;
+    QThreadPool threadPool;
+    bool searchRunning;
+    bool startingSearchJobs;
+    QString searchString;
+    NetworkItemPtr searchItem;
+    QList<NetworkItemPtr> searchQueue;
+    QList<SharePtr> searchResults;
+    QSet<QString> staleWorkgroups;
+    QSet<QString> staleHosts;
+    bool networkScanned;
 };
 
 class Smb4KClientStatic
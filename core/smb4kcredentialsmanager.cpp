@@ -17,12 +17,22 @@
 #else
 #include <qapplicationstatic.h>
 #endif
+#include <QDeadlineTimer>
 #include <QDebug>
 #include <QEventLoop>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTimer>
 
 // QtKeychain include
 #include <qt6keychain/keychain.h>
 
+// system includes
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 // KDE & Qt includes for migrate() function
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -35,8 +45,92 @@ public:
     Smb4KCredentialsManager instance;
 };
 
+#define CACHE_TTL 60000
+
+//
+// An entry of the credentials cache. The credentials are kept in memory
+// that is locked, so that it is never swapped out, and that is zeroized
+// when the entry is destroyed.
+//
+class Smb4KCredentialsCacheEntry
+{
+public:
+    Smb4KCredentialsCacheEntry(int returnCode, const QString &credentials)
+        : m_returnCode(returnCode)
+        , m_data(nullptr)
+        , m_size(0)
+        , m_length(0)
+        , m_expiry(CACHE_TTL)
+    {
+        QByteArray utf8 = credentials.toUtf8();
+
+        if (!utf8.isEmpty()) {
+            long pageSize = sysconf(_SC_PAGESIZE);
+            m_size = ((utf8.size() / pageSize) + 1) * pageSize;
+
+            void *data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (data != MAP_FAILED) {
+                m_data = static_cast<char *>(data);
+                (void)mlock(m_data, m_size);
+#if defined(MADV_DONTDUMP)
+                (void)madvise(m_data, m_size, MADV_DONTDUMP);
+#endif
+                memcpy(m_data, utf8.constData(), utf8.size());
+                m_length = utf8.size();
+            } else {
+                m_size = 0;
+                m_returnCode = QKeychain::OtherError;
+            }
+
+            utf8.fill('\0');
+        }
+    }
+
+    ~Smb4KCredentialsCacheEntry()
+    {
+        if (m_data) {
+            volatile char *data = m_data;
+
+            for (size_t i = 0; i < m_size; ++i) {
+                data[i] = 0;
+            }
+
+            (void)munlock(m_data, m_size);
+            (void)munmap(m_data, m_size);
+        }
+    }
+
+    int returnCode() const
+    {
+        return m_returnCode;
+    }
+
+    QString credentials() const
+    {
+        return m_data ? QString::fromUtf8(m_data, m_length) : QString();
+    }
+
+    bool isExpired() const
+    {
+        return m_expiry.hasExpired();
+    }
+
+private:
+    Q_DISABLE_COPY(Smb4KCredentialsCacheEntry)
+    int m_returnCode;
+    char *m_data;
+    size_t m_size;
+    size_t m_length;
+    QDeadlineTimer m_expiry;
+};
+
 class Smb4KCredentialsManagerPrivate
 {
+public:
+    QHash<QString, QSharedPointer<Smb4KCredentialsCacheEntry>> cache;
+    QHash<QString, QKeychain::ReadPasswordJob *> runningReadJobs;
+    QTimer expiryTimer;
 };
 
 Q_APPLICATION_STATIC(Smb4KCredentialsManagerStatic, p);
@@ -45,6 +139,11 @@ Smb4KCredentialsManager::Smb4KCredentialsManager(QObject *parent)
     : QObject(parent)
     , d(new Smb4KCredentialsManagerPrivate)
 {
+    d->expiryTimer.setInterval(CACHE_TTL);
+
+    connect(&d->expiryTimer, &QTimer::timeout, this, &Smb4KCredentialsManager::slotRemoveExpiredEntries);
+    connect(this, &Smb4KCredentialsManager::credentialsUpdated, this, &Smb4KCredentialsManager::slotClearCache);
+
     // For backward compatibility. Remove in the future again.
     migrate();
 }
@@ -65,66 +164,77 @@ bool Smb4KCredentialsManager::readLoginCredentials(const NetworkItemPtr &network
 
     if (networkItem) {
         QString credentials;
+        const QStringList keys = lookupKeys(networkItem);
 
-        switch (networkItem->type()) {
-        case Host: {
-            QString key = networkItem->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort);
-
+        for (const QString &key : keys) {
             int returnCode = read(key, &credentials);
 
-            if (returnCode == QKeychain::EntryNotFound) {
-                key = QStringLiteral("DEFAULT::") + Smb4KProfileManager::self()->activeProfile();
-                returnCode = read(key, &credentials);
+            if (returnCode != QKeychain::EntryNotFound) {
+                success = (returnCode == QKeychain::NoError);
+                break;
             }
-
-            success = (returnCode == QKeychain::NoError);
-
-            break;
         }
-        case Share: {
-            SharePtr share = networkItem.staticCast<Smb4KShare>();
-            QString key;
-
-            if (!share->isHomesShare()) {
-                key = share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort);
-            } else {
-                key = share->homeUrl().toString(QUrl::RemoveUserInfo | QUrl::RemovePort);
-            }
 
-            int returnCode = read(key, &credentials);
+        if (!credentials.isEmpty()) {
+            QUrl url = networkItem->url();
+            url.setUserInfo(credentials);
 
-            if (returnCode == QKeychain::EntryNotFound) {
-                key = share->url().adjusted(QUrl::RemovePath | QUrl::StripTrailingSlash).toString(QUrl::RemovePassword | QUrl::RemovePort);
+            networkItem->setUrl(url);
+        }
+    }
 
-                returnCode = read(key, &credentials);
+    return success;
+}
 
-                if (returnCode == QKeychain::EntryNotFound) {
-                    key = QStringLiteral("DEFAULT::") + Smb4KProfileManager::self()->activeProfile();
-                    returnCode = read(key, &credentials);
-                }
-            }
+void Smb4KCredentialsManager::fetchLoginCredentials(const QList<NetworkItemPtr> &networkItems)
+{
+    //
+    // Look up every key only once, even if it is needed by several network
+    // items or is already being read
+    //
+    QSharedPointer<QSet<QKeychain::Job *>> runningJobs = QSharedPointer<QSet<QKeychain::Job *>>::create();
+    QSet<QString> keys;
+
+    for (const NetworkItemPtr &networkItem : networkItems) {
+        const QStringList itemKeys = lookupKeys(networkItem);
+
+        for (const QString &key : itemKeys) {
+            keys.insert(key);
+        }
+    }
 
-            success = (returnCode == QKeychain::NoError);
+    for (const QString &key : std::as_const(keys)) {
+        QSharedPointer<Smb4KCredentialsCacheEntry> entry = d->cache.value(key);
 
-            break;
-        }
-        default: {
-            QString key = QStringLiteral("DEFAULT::") + Smb4KProfileManager::self()->activeProfile();
-            int returnCode = read(key, &credentials);
-            success = (returnCode == QKeychain::NoError);
-            break;
+        if (!entry || entry->isExpired()) {
+            runningJobs->insert(startReadJob(key));
         }
+    }
+
+    auto finishFetch = [this, networkItems]() {
+        for (const NetworkItemPtr &networkItem : networkItems) {
+            readLoginCredentials(networkItem);
         }
 
-        if (!credentials.isEmpty()) {
-            QUrl url = networkItem->url();
-            url.setUserInfo(credentials);
+        Q_EMIT loginCredentialsFetched(networkItems);
+    };
 
-            networkItem->setUrl(url);
-        }
+    if (runningJobs->isEmpty()) {
+        QTimer::singleShot(0, this, finishFetch);
+        return;
     }
 
-    return success;
+    const QSet<QKeychain::Job *> jobs = *runningJobs;
+
+    for (QKeychain::Job *job : jobs) {
+        connect(job, &QKeychain::Job::finished, this, [runningJobs, job, finishFetch]() {
+            runningJobs->remove(job);
+
+            if (runningJobs->isEmpty()) {
+                finishFetch();
+            }
+        });
+    }
 }
 
 bool Smb4KCredentialsManager::writeLoginCredentials(const NetworkItemPtr &networkItem)
@@ -208,44 +318,87 @@ bool Smb4KCredentialsManager::hasDefaultCredentials() const
 
 int Smb4KCredentialsManager::read(const QString &key, QString *credentials) const
 {
-    int returnValue = QKeychain::NoError;
-    QString errorMessage;
+    QSharedPointer<Smb4KCredentialsCacheEntry> entry = d->cache.value(key);
 
-    QEventLoop loop;
+    if (!entry || entry->isExpired()) {
+        //
+        // Wait for the running or a newly started job. Its result is put
+        // into the cache before the event loop quits.
+        //
+        QEventLoop loop;
 
-    QKeychain::ReadPasswordJob *readPasswordJob = new QKeychain::ReadPasswordJob(QStringLiteral("Smb4K"));
+        QKeychain::Job *readPasswordJob = startReadJob(key);
+        QObject::connect(readPasswordJob, &QKeychain::Job::finished, &loop, &QEventLoop::quit);
+
+        loop.exec();
+
+        entry = d->cache.value(key);
+    }
+
+    if (!entry) {
+        return QKeychain::OtherError;
+    }
+
+    if (entry->returnCode() == QKeychain::NoError) {
+        *credentials = entry->credentials();
+    }
+
+    return entry->returnCode();
+}
+
+QKeychain::Job *Smb4KCredentialsManager::startReadJob(const QString &key) const
+{
+    QKeychain::ReadPasswordJob *readPasswordJob = d->runningReadJobs.value(key);
+
+    if (readPasswordJob) {
+        return readPasswordJob;
+    }
+
+    readPasswordJob = new QKeychain::ReadPasswordJob(QStringLiteral("Smb4K"));
     readPasswordJob->setAutoDelete(true);
     readPasswordJob->setKey(key);
 
-    QObject::connect(readPasswordJob, &QKeychain::ReadPasswordJob::finished, [&]() {
-        if ((returnValue = readPasswordJob->error()) == QKeychain::NoError) {
-            *credentials = readPasswordJob->textData();
-        } else {
-            errorMessage = readPasswordJob->errorString();
+    d->runningReadJobs.insert(key, readPasswordJob);
+
+    QObject::connect(readPasswordJob, &QKeychain::ReadPasswordJob::finished, this, [this, key, readPasswordJob]() {
+        d->runningReadJobs.remove(key);
+
+        int returnValue = readPasswordJob->error();
+        QString credentials;
+
+        switch (returnValue) {
+        case QKeychain::NoError: {
+            credentials = readPasswordJob->textData();
+            break;
+        }
+        case QKeychain::CouldNotDeleteEntry:
+        case QKeychain::AccessDenied:
+        case QKeychain::NoBackendAvailable:
+        case QKeychain::NotImplemented:
+        case QKeychain::OtherError: {
+            Smb4KNotification::keychainError(readPasswordJob->errorString());
+            break;
+        }
+        default: {
+            break;
+        }
         }
 
-        loop.quit();
+        //
+        // Failures are cached as well, so that the user is not notified
+        // over and over again
+        //
+        d->cache.insert(key, QSharedPointer<Smb4KCredentialsCacheEntry>::create(returnValue, credentials));
+        credentials.fill(QChar());
+
+        if (!d->expiryTimer.isActive()) {
+            d->expiryTimer.start();
+        }
     });
 
     readPasswordJob->start();
 
-    loop.exec();
-
-    switch (returnValue) {
-    case QKeychain::CouldNotDeleteEntry:
-    case QKeychain::AccessDenied:
-    case QKeychain::NoBackendAvailable:
-    case QKeychain::NotImplemented:
-    case QKeychain::OtherError: {
-        Smb4KNotification::keychainError(errorMessage);
-        break;
-    }
-    default: {
-        break;
-    }
-    }
-
-    return returnValue;
+    return readPasswordJob;
 }
 
 int Smb4KCredentialsManager::write(const QString &key, const QString &credentials) const
@@ -272,6 +425,8 @@ int Smb4KCredentialsManager::write(const QString &key, const QString &credential
 
     loop.exec();
 
+    d->cache.remove(key);
+
     switch (returnValue) {
     case QKeychain::CouldNotDeleteEntry:
     case QKeychain::AccessDenied:
@@ -312,6 +467,8 @@ int Smb4KCredentialsManager::remove(const QString &key)
 
     loop.exec();
 
+    d->cache.remove(key);
+
     switch (returnValue) {
     case QKeychain::CouldNotDeleteEntry:
     case QKeychain::AccessDenied:
@@ -329,6 +486,60 @@ int Smb4KCredentialsManager::remove(const QString &key)
     return returnValue;
 }
 
+QStringList Smb4KCredentialsManager::lookupKeys(const NetworkItemPtr &networkItem) const
+{
+    QStringList keys;
+
+    switch (networkItem->type()) {
+    case Host: {
+        keys << networkItem->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort);
+        break;
+    }
+    case Share: {
+        SharePtr share = networkItem.staticCast<Smb4KShare>();
+
+        if (!share->isHomesShare()) {
+            keys << share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort);
+        } else {
+            keys << share->homeUrl().toString(QUrl::RemoveUserInfo | QUrl::RemovePort);
+        }
+
+        keys << share->url().adjusted(QUrl::RemovePath | QUrl::StripTrailingSlash).toString(QUrl::RemovePassword | QUrl::RemovePort);
+        break;
+    }
+    default: {
+        break;
+    }
+    }
+
+    keys << QStringLiteral("DEFAULT::") + Smb4KProfileManager::self()->activeProfile();
+
+    return keys;
+}
+
+void Smb4KCredentialsManager::slotClearCache()
+{
+    d->cache.clear();
+    d->expiryTimer.stop();
+}
+
+void Smb4KCredentialsManager::slotRemoveExpiredEntries()
+{
+    auto it = d->cache.begin();
+
+    while (it != d->cache.end()) {
+        if ((*it)->isExpired()) {
+            it = d->cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (d->cache.isEmpty()) {
+        d->expiryTimer.stop();
+    }
+}
+
 void Smb4KCredentialsManager::migrate()
 {
     // Only consider migrating login credentials if Smb4K was already installed and
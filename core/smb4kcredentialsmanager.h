@@ -18,6 +18,11 @@
 // forward declarations
 class Smb4KCredentialsManagerPrivate;
 
+namespace QKeychain
+{
+class Job;
+}
+
 /**
  * This class manages the access to the credentials
  *
@@ -56,6 +61,20 @@ public:
      */
     bool readLoginCredentials(const NetworkItemPtr &networkItem);
 
+    /**
+     * Read the login credentials for the given @p networkItems from the
+     * secure storage asynchronously. The keys of all network items are
+     * looked up in one batch, each distinct key only once. The results
+     * are kept in a short-lived cache in locked memory, so that calls to
+     * readLoginCredentials() for these network items do not access the
+     * secure storage. When all keys were looked up, the credentials are
+     * set and the loginCredentialsFetched() signal is emitted.
+     *
+     * @param networkItems  The network items for which the login
+     *                      credentials should be read
+     */
+    void fetchLoginCredentials(const QList<NetworkItemPtr> &networkItems);
+
     /**
      * Write the login credentials for the given @p networkItem to the
      * secure storage.
@@ -107,7 +126,47 @@ Q_SIGNALS:
      */
     void credentialsUpdated(const QUrl &url);
 
+    /**
+     * This signal is emitted when the login credentials requested with
+     * fetchLoginCredentials() were read and set.
+     *
+     * @param networkItems  The network items
+     */
+    void loginCredentialsFetched(const QList<NetworkItemPtr> &networkItems);
+
+protected Q_SLOTS:
+    /**
+     * Clear the cache of the login credentials
+     */
+    void slotClearCache();
+
+    /**
+     * Remove the expired entries from the cache of the login credentials
+     */
+    void slotRemoveExpiredEntries();
+
 private:
+    /**
+     * Returns the keys under which the login credentials for the given
+     * @p networkItem are looked up, in the order they are tried.
+     *
+     * @param networkItem   The network item
+     *
+     * @returns the list of keys
+     */
+    QStringList lookupKeys(const NetworkItemPtr &networkItem) const;
+
+    /**
+     * Start reading the login credentials stored under @p key from the
+     * secure storage asynchronously. The result is put into the cache. If
+     * the key is already being read, the running job is returned.
+     *
+     * @param key           The key
+     *
+     * @returns the job reading the login credentials
+     */
+    QKeychain::Job *startReadJob(const QString &key) const;
+
     /**
      * Read login credentials from the secure storage.
      *
@@ -8,6 +8,7 @@
 // application specific includes
 #include "smb4kcustomsettingsmanager.h"
 #include "smb4kcustomsettings.h"
+#include "smb4kdeferredwriter.h"
 #include "smb4kglobal.h"
 #include "smb4khomesshareshandler.h"
 #include "smb4khost.h"
@@ -15,6 +16,7 @@
 #include "smb4kprofilemanager.h"
 #include "smb4ksettings.h"
 #include "smb4kshare.h"
+#include "smb4ksnapshotcache.h"
 
 #if defined(Q_OS_LINUX)
 #include "smb4kmountsettings_linux.h"
@@ -28,7 +30,9 @@
 #else
 #include <qapplicationstatic.h>
 #endif
+#include <QDataStream>
 #include <QDebug>
+#include <QHash>
 #include <QRegularExpression>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -42,8 +46,20 @@ class Smb4KCustomSettingsManagerPrivate
 {
 public:
     QList<CustomSettingsPtr> customSettings;
+    QHash<QString, QList<CustomSettingsPtr>> index;
+    QHash<QString, QHash<QString, QList<CustomSettingsPtr>>> profileIndexes;
+    Smb4KDeferredWriter *writer;
+    QScopedPointer<Smb4KSnapshotCache> snapshot;
 };
 
+//
+// The key under which custom settings are indexed
+//
+static QString indexKey(const QUrl &url)
+{
+    return url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort | QUrl::StripTrailingSlash);
+}
+
 class Smb4KCustomSettingsManagerStatic
 {
 public:
@@ -52,6 +68,149 @@ public:
 
 Q_APPLICATION_STATIC(Smb4KCustomSettingsManagerStatic, p);
 
+//
+// Set a custom setting from its name and value as they are stored in the
+// file
+//
+static void setCustomSetting(const CustomSettingsPtr &settings, QStringView name, const QString &value)
+{
+    if (name == QStringLiteral("kerberos")) {
+        bool ok = false;
+        bool useKerberos = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseKerberos(useKerberos);
+        }
+    } else if (name == QStringLiteral("mac_address")) {
+        QString macAddress = value;
+
+        QRegularExpression expression(QStringLiteral("..\\:..\\:..\\:..\\:..\\:.."));
+
+        if (expression.match(macAddress).hasMatch()) {
+            settings->setMacAddress(macAddress);
+        }
+    } else if (name == QStringLiteral("wol_send_before_first_scan")) {
+        bool ok = false;
+        bool send = value.toInt(&ok);
+
+        if (ok) {
+            settings->setWakeOnLanSendBeforeNetworkScan(send);
+        }
+    } else if (name == QStringLiteral("wol_send_before_mount")) {
+        bool ok = false;
+        bool send = value.toInt(&ok);
+
+        if (ok) {
+            settings->setWakeOnLanSendBeforeMount(send);
+        }
+    } else if (name == QStringLiteral("remount")) {
+        bool ok = false;
+        int remount = value.toInt(&ok);
+
+        if (ok) {
+            settings->setRemount(remount);
+        }
+    } else if (name == QStringLiteral("use_ids")) {
+        bool ok = false;
+        bool useIds = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseIds(useIds);
+        }
+    } else if (name == QStringLiteral("use_file_mode")) {
+        bool ok = false;
+        bool useFileMode = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseFileMode(useFileMode);
+        }
+    } else if (name == QStringLiteral("file_mode")) {
+        settings->setFileMode(value);
+    } else if (name == QStringLiteral("use_directory_mode")) {
+        bool ok = false;
+        bool useDirectoryMode = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseDirectoryMode(useDirectoryMode);
+        }
+    } else if (name == QStringLiteral("directory_mode")) {
+        settings->setDirectoryMode(value);
+    } else if (name == QStringLiteral("use_client_protocol_versions")) {
+        bool ok = false;
+        bool useClientProtocolVersions = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseClientProtocolVersions(useClientProtocolVersions);
+        }
+    } else if (name == QStringLiteral("minimal_client_protocol_version")) {
+        bool ok = false;
+        int minimalClientProtocolVersion = value.toInt(&ok);
+
+        if (ok) {
+            settings->setMinimalClientProtocolVersion(minimalClientProtocolVersion);
+        }
+    } else if (name == QStringLiteral("maximal_client_protocol_version")) {
+        bool ok = false;
+        int maximalClientProtocolVersion = value.toInt(&ok);
+
+        if (ok) {
+            settings->setMaximalClientProtocolVersion(maximalClientProtocolVersion);
+        }
+    }
+#if defined(Q_OS_LINUX)
+    else if (name == QStringLiteral("cifs_unix_extensions_support")) {
+        bool ok = false;
+        bool cifsUnixExtensionsSupported = value.toInt(&ok);
+
+        if (ok) {
+            settings->setCifsUnixExtensionsSupport(cifsUnixExtensionsSupported);
+        }
+    } else if (name == QStringLiteral("use_smb_mount_protocol_version")) {
+        bool ok = false;
+        bool useMountProtocolVersion = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseMountProtocolVersion(useMountProtocolVersion);
+        }
+    } else if (name == QStringLiteral("smb_mount_protocol_version")) {
+        bool ok = false;
+        int mountProtocolVersion = value.toInt(&ok);
+
+        if (ok) {
+            settings->setMountProtocolVersion(mountProtocolVersion);
+        }
+    } else if (name == QStringLiteral("use_security_mode")) {
+        bool ok = false;
+        bool useSecurityMode = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseSecurityMode(useSecurityMode);
+        }
+    } else if (name == QStringLiteral("security_mode")) {
+        bool ok = false;
+        int securityMode = value.toInt(&ok);
+
+        if (ok) {
+            settings->setSecurityMode(securityMode);
+        }
+    } else if (name == QStringLiteral("use_write_access")) {
+        bool ok = false;
+        bool useWriteAccess = value.toInt(&ok);
+
+        if (ok) {
+            settings->setUseWriteAccess(useWriteAccess);
+        }
+    } else if (name == QStringLiteral("write_access")) {
+        bool ok = false;
+        int writeAccess = value.toInt(&ok);
+
+        if (ok) {
+            settings->setWriteAccess(writeAccess);
+        }
+    }
+#endif
+}
+
 Smb4KCustomSettingsManager::Smb4KCustomSettingsManager(QObject *parent)
     : QObject(parent)
     , d(new Smb4KCustomSettingsManagerPrivate)
@@ -65,6 +224,20 @@ Smb4KCustomSettingsManager::Smb4KCustomSettingsManager(QObject *parent)
         dir.mkpath(path);
     }
 
+    d->writer = new Smb4KDeferredWriter(path + QDir::separator() + QStringLiteral("custom_options.xml"),
+                                        [this](QIODevice *device) {
+                                            return writeFile(device);
+                                        },
+                                        this);
+
+    d->snapshot.reset(new Smb4KSnapshotCache(path + QDir::separator() + QStringLiteral("custom_options.xml"), 1));
+
+    connect(d->writer, &Smb4KDeferredWriter::fileWritten, this, [this]() {
+        d->snapshot->save([this](QDataStream &stream) {
+            writeSnapshot(stream);
+        });
+    });
+
     read();
 
     connect(Smb4KProfileManager::self(), &Smb4KProfileManager::profileRemoved, this, &Smb4KCustomSettingsManager::slotProfileRemoved);
@@ -74,6 +247,7 @@ Smb4KCustomSettingsManager::Smb4KCustomSettingsManager(QObject *parent)
 
 Smb4KCustomSettingsManager::~Smb4KCustomSettingsManager()
 {
+    d->writer->flush();
 }
 
 Smb4KCustomSettingsManager *Smb4KCustomSettingsManager::self()
@@ -186,11 +360,10 @@ CustomSettingsPtr Smb4KCustomSettingsManager::findCustomSettings(const QUrl &url
     CustomSettingsPtr settings;
 
     if (url.isValid() && url.scheme() == QStringLiteral("smb")) {
-        QList<CustomSettingsPtr> settingsList = customSettings(false);
+        const QList<CustomSettingsPtr> settingsList = findIndexedSettings(indexKey(url));
 
-        for (const CustomSettingsPtr &cs : std::as_const(settingsList)) {
-            if (cs->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort | QUrl::StripTrailingSlash)
-                == url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort | QUrl::StripTrailingSlash)) {
+        for (const CustomSettingsPtr &cs : settingsList) {
+            if (cs->hasCustomSettings(false)) {
                 settings = cs;
                 break;
             }
@@ -200,6 +373,42 @@ CustomSettingsPtr Smb4KCustomSettingsManager::findCustomSettings(const QUrl &url
     return settings;
 }
 
+QList<CustomSettingsPtr> Smb4KCustomSettingsManager::findIndexedSettings(const QString &key) const
+{
+    if (Smb4KSettings::useProfiles()) {
+        auto profileIndex = d->profileIndexes.constFind(Smb4KProfileManager::self()->activeProfile());
+
+        if (profileIndex != d->profileIndexes.constEnd()) {
+            return profileIndex->value(key);
+        }
+
+        return QList<CustomSettingsPtr>();
+    }
+
+    return d->index.value(key);
+}
+
+void Smb4KCustomSettingsManager::addToIndex(const CustomSettingsPtr &settings)
+{
+    //
+    // Like the list, the index keeps the entries in the order they were
+    // added
+    //
+    QString key = indexKey(settings->url());
+    d->index[key] << settings;
+    d->profileIndexes[settings->profile()][key] << settings;
+}
+
+void Smb4KCustomSettingsManager::rebuildIndex()
+{
+    d->index.clear();
+    d->profileIndexes.clear();
+
+    for (const CustomSettingsPtr &settings : std::as_const(d->customSettings)) {
+        addToIndex(settings);
+    }
+}
+
 QList<CustomSettingsPtr> Smb4KCustomSettingsManager::customSettings(bool withoutRemountOnce) const
 {
     QList<CustomSettingsPtr> settingsList;
@@ -261,6 +470,8 @@ void Smb4KCustomSettingsManager::saveCustomSettings(const QList<CustomSettingsPt
         }
     }
 
+    rebuildIndex();
+
     for (const CustomSettingsPtr &settings : settingsList) {
         add(settings);
     }
@@ -283,6 +494,7 @@ bool Smb4KCustomSettingsManager::add(const CustomSettingsPtr &settings)
                 settings->setProfile(Smb4KProfileManager::self()->activeProfile());
             }
             d->customSettings << settings;
+            addToIndex(settings);
         }
 
         // Propagate the settings to the host's shares if the type is 'Host'
@@ -308,15 +520,37 @@ bool Smb4KCustomSettingsManager::add(const CustomSettingsPtr &settings)
 bool Smb4KCustomSettingsManager::remove(const CustomSettingsPtr &settings)
 {
     bool removedSettings = false;
+    QString key = indexKey(settings->url());
+    QList<CustomSettingsPtr> settingsList = findIndexedSettings(key);
+
+    if (!settingsList.isEmpty()) {
+        CustomSettingsPtr knownSettings = settingsList.first();
+
+        auto it = d->index.find(key);
 
-    // FIXME: Use while loop here
-    for (int i = 0; i < d->customSettings.size(); i++) {
-        if ((!Smb4KSettings::useProfiles() || Smb4KProfileManager::self()->activeProfile() == d->customSettings.at(i)->profile())
-            && d->customSettings.at(i)->url().matches(settings->url(), QUrl::RemoveUserInfo | QUrl::RemovePort | QUrl::StripTrailingSlash)) {
-            d->customSettings.takeAt(i).clear();
-            removedSettings = true;
-            break;
+        if (it != d->index.end()) {
+            it->removeOne(knownSettings);
+
+            if (it->isEmpty()) {
+                d->index.erase(it);
+            }
         }
+
+        auto profileIndex = d->profileIndexes.find(knownSettings->profile());
+
+        if (profileIndex != d->profileIndexes.end()) {
+            auto profileIt = profileIndex->find(key);
+
+            if (profileIt != profileIndex->end()) {
+                profileIt->removeOne(knownSettings);
+
+                if (profileIt->isEmpty()) {
+                    profileIndex->erase(profileIt);
+                }
+            }
+        }
+
+        removedSettings = d->customSettings.removeOne(knownSettings);
     }
 
     return removedSettings;
@@ -328,6 +562,33 @@ void Smb4KCustomSettingsManager::read()
         d->customSettings.takeFirst().clear();
     }
 
+    //
+    // Load the snapshot of the file, if it is up to date. Otherwise, read
+    // the file and take a new snapshot.
+    //
+    bool snapshotLoaded = d->snapshot->load([this](QDataStream &stream) {
+        return readSnapshot(stream);
+    });
+
+    if (!snapshotLoaded) {
+        while (!d->customSettings.isEmpty()) {
+            d->customSettings.takeFirst().clear();
+        }
+
+        if (readFile()) {
+            d->snapshot->save([this](QDataStream &stream) {
+                writeSnapshot(stream);
+            });
+        }
+    }
+
+    rebuildIndex();
+}
+
+bool Smb4KCustomSettingsManager::readFile()
+{
+    bool success = true;
+
     QFile xmlFile(dataLocation() + QDir::separator() + QStringLiteral("custom_options.xml"));
 
     if (xmlFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -368,141 +629,8 @@ void Smb4KCustomSettingsManager::read()
                                         xmlReader.readNext();
 
                                         if (xmlReader.isStartElement()) {
-                                            if (xmlReader.name() == QStringLiteral("kerberos")) {
-                                                bool ok = false;
-                                                bool useKerberos = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseKerberos(useKerberos);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("mac_address")) {
-                                                QString macAddress = xmlReader.readElementText();
-
-                                                QRegularExpression expression(QStringLiteral("..\\:..\\:..\\:..\\:..\\:.."));
-
-                                                if (expression.match(macAddress).hasMatch()) {
-                                                    settings->setMacAddress(macAddress);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("wol_send_before_first_scan")) {
-                                                bool ok = false;
-                                                bool send = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setWakeOnLanSendBeforeNetworkScan(send);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("wol_send_before_mount")) {
-                                                bool ok = false;
-                                                bool send = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setWakeOnLanSendBeforeMount(send);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("remount")) {
-                                                bool ok = false;
-                                                int remount = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setRemount(remount);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("use_ids")) {
-                                                bool ok = false;
-                                                bool useIds = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseIds(useIds);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("use_file_mode")) {
-                                                bool ok = false;
-                                                bool useFileMode = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseFileMode(useFileMode);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("file_mode")) {
-                                                settings->setFileMode(xmlReader.readElementText());
-                                            } else if (xmlReader.name() == QStringLiteral("use_directory_mode")) {
-                                                bool ok = false;
-                                                bool useDirectoryMode = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseDirectoryMode(useDirectoryMode);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("directory_mode")) {
-                                                settings->setDirectoryMode(xmlReader.readElementText());
-                                            } else if (xmlReader.name() == QStringLiteral("use_client_protocol_versions")) {
-                                                bool ok = false;
-                                                bool useClientProtocolVersions = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseClientProtocolVersions(useClientProtocolVersions);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("minimal_client_protocol_version")) {
-                                                bool ok = false;
-                                                int minimalClientProtocolVersion = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setMinimalClientProtocolVersion(minimalClientProtocolVersion);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("maximal_client_protocol_version")) {
-                                                bool ok = false;
-                                                int maximalClientProtocolVersion = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setMaximalClientProtocolVersion(maximalClientProtocolVersion);
-                                                }
-                                            }
-#if defined(Q_OS_LINUX)
-                                            else if (xmlReader.name() == QStringLiteral("cifs_unix_extensions_support")) {
-                                                bool ok = false;
-                                                bool cifsUnixExtensionsSupported = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setCifsUnixExtensionsSupport(cifsUnixExtensionsSupported);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("use_smb_mount_protocol_version")) {
-                                                bool ok = false;
-                                                bool useMountProtocolVersion = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseMountProtocolVersion(useMountProtocolVersion);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("smb_mount_protocol_version")) {
-                                                bool ok = false;
-                                                int mountProtocolVersion = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setMountProtocolVersion(mountProtocolVersion);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("use_security_mode")) {
-                                                bool ok = false;
-                                                bool useSecurityMode = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseSecurityMode(useSecurityMode);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("security_mode")) {
-                                                bool ok = false;
-                                                int securityMode = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setSecurityMode(securityMode);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("use_write_access")) {
-                                                bool ok = false;
-                                                bool useWriteAccess = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setUseWriteAccess(useWriteAccess);
-                                                }
-                                            } else if (xmlReader.name() == QStringLiteral("write_access")) {
-                                                bool ok = false;
-                                                int writeAccess = xmlReader.readElementText().toInt(&ok);
-
-                                                if (ok) {
-                                                    settings->setWriteAccess(writeAccess);
-                                                }
-                                            }
-#endif
+                                            QString name = xmlReader.name().toString();
+                                            setCustomSetting(settings, name, xmlReader.readElementText());
                                         }
                                     }
                                 }
@@ -519,62 +647,132 @@ void Smb4KCustomSettingsManager::read()
 
         if (xmlReader.hasError()) {
             Smb4KNotification::readingFileFailed(xmlFile, xmlReader.errorString());
+            success = false;
         }
     } else {
         if (xmlFile.exists()) {
             Smb4KNotification::openingFileFailed(xmlFile);
+            success = false;
         }
     }
+    return success;
 }
 
 void Smb4KCustomSettingsManager::write()
 {
-    QFile xmlFile(dataLocation() + QDir::separator() + QStringLiteral("custom_options.xml"));
+    d->writer->scheduleWrite();
+}
 
+bool Smb4KCustomSettingsManager::writeFile(QIODevice *device)
+{
     if (d->customSettings.isEmpty()) {
-        xmlFile.remove();
-        return;
+        return false;
     }
 
-    if (xmlFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QXmlStreamWriter xmlWriter(&xmlFile);
-        xmlWriter.setAutoFormatting(true);
-        xmlWriter.writeStartDocument();
-        xmlWriter.writeStartElement(QStringLiteral("custom_options"));
-        xmlWriter.writeAttribute(QStringLiteral("version"), QStringLiteral("3.0"));
+    QXmlStreamWriter xmlWriter(device);
+    xmlWriter.setAutoFormatting(true);
+    xmlWriter.writeStartDocument();
+    xmlWriter.writeStartElement(QStringLiteral("custom_options"));
+    xmlWriter.writeAttribute(QStringLiteral("version"), QStringLiteral("3.0"));
 
-        for (const CustomSettingsPtr &settings : std::as_const(d->customSettings)) {
-            if (settings->hasCustomSettings()) {
-                xmlWriter.writeStartElement(QStringLiteral("options"));
-                xmlWriter.writeAttribute(QStringLiteral("type"), settings->type() == Host ? QStringLiteral("host") : QStringLiteral("share"));
-                xmlWriter.writeAttribute(QStringLiteral("profile"), settings->profile());
+    for (const CustomSettingsPtr &settings : std::as_const(d->customSettings)) {
+        if (settings->hasCustomSettings()) {
+            xmlWriter.writeStartElement(QStringLiteral("options"));
+            xmlWriter.writeAttribute(QStringLiteral("type"), settings->type() == Host ? QStringLiteral("host") : QStringLiteral("share"));
+            xmlWriter.writeAttribute(QStringLiteral("profile"), settings->profile());
 
-                xmlWriter.writeTextElement(QStringLiteral("workgroup"), settings->workgroupName());
-                xmlWriter.writeTextElement(QStringLiteral("url"), settings->url().toDisplayString());
-                xmlWriter.writeTextElement(QStringLiteral("ip"), settings->ipAddress());
+            xmlWriter.writeTextElement(QStringLiteral("workgroup"), settings->workgroupName());
+            xmlWriter.writeTextElement(QStringLiteral("url"), settings->url().toDisplayString());
+            xmlWriter.writeTextElement(QStringLiteral("ip"), settings->ipAddress());
 
-                xmlWriter.writeStartElement(QStringLiteral("custom"));
+            xmlWriter.writeStartElement(QStringLiteral("custom"));
 
-                QMap<QString, QString> map = settings->customSettings();
-                QMapIterator<QString, QString> i(map);
+            QMap<QString, QString> map = settings->customSettings();
+            QMapIterator<QString, QString> i(map);
 
-                while (i.hasNext()) {
-                    i.next();
+            while (i.hasNext()) {
+                i.next();
 
-                    if (!i.value().isEmpty()) {
-                        xmlWriter.writeTextElement(i.key(), i.value());
-                    }
+                if (!i.value().isEmpty()) {
+                    xmlWriter.writeTextElement(i.key(), i.value());
                 }
+            }
+
+            xmlWriter.writeEndElement();
+            xmlWriter.writeEndElement();
+        }
+    }
 
-                xmlWriter.writeEndElement();
-                xmlWriter.writeEndElement();
+    xmlWriter.writeEndDocument();
+
+    return true;
+}
+
+bool Smb4KCustomSettingsManager::readSnapshot(QDataStream &stream)
+{
+    quint32 count = 0;
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        bool isHost = false;
+        QString profile, workgroupName, url, ipAddress;
+        QMap<QString, QString> map;
+
+        stream >> isHost >> profile >> workgroupName >> url >> ipAddress >> map;
+
+        CustomSettingsPtr settings = CustomSettingsPtr::create();
+        settings->setProfile(profile);
+
+        if (isHost) {
+            settings->setNetworkItem(new Smb4KHost());
+        } else {
+            settings->setNetworkItem(new Smb4KShare());
+        }
+
+        settings->setWorkgroupName(workgroupName);
+        settings->setUrl(QUrl(url));
+        settings->setIpAddress(ipAddress);
+
+        QMapIterator<QString, QString> it(map);
+
+        while (it.hasNext()) {
+            it.next();
+            setCustomSetting(settings, it.key(), it.value());
+        }
+
+        d->customSettings << settings;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+void Smb4KCustomSettingsManager::writeSnapshot(QDataStream &stream)
+{
+    QList<CustomSettingsPtr> customSettingsList;
+
+    for (const CustomSettingsPtr &settings : std::as_const(d->customSettings)) {
+        if (settings->hasCustomSettings()) {
+            customSettingsList << settings;
+        }
+    }
+
+    stream << quint32(customSettingsList.size());
+
+    for (const CustomSettingsPtr &settings : std::as_const(customSettingsList)) {
+        QMap<QString, QString> map = settings->customSettings();
+
+        auto it = map.begin();
+
+        while (it != map.end()) {
+            if (it.value().isEmpty()) {
+                it = map.erase(it);
+            } else {
+                ++it;
             }
         }
 
-        xmlWriter.writeEndDocument();
-        xmlFile.close();
-    } else {
-        Smb4KNotification::openingFileFailed(xmlFile);
+        stream << (settings->type() == Host) << settings->profile() << settings->workgroupName() << settings->url().toDisplayString()
+               << settings->ipAddress() << map;
     }
 }
 
@@ -595,6 +793,8 @@ void Smb4KCustomSettingsManager::slotProfileRemoved(const QString &name)
         }
     }
 
+    rebuildIndex();
+
     write();
     Q_EMIT updated();
 }
@@ -607,6 +807,8 @@ void Smb4KCustomSettingsManager::slotProfileMigrated(const QString &oldName, con
         }
     }
 
+    rebuildIndex();
+
     write();
     Q_EMIT updated();
 }
@@ -17,6 +17,8 @@
 #include <QScopedPointer>
 
 // forward declarations
+class QDataStream;
+class QIODevice;
 class Smb4KCustomSettingsManagerPrivate;
 
 /**
@@ -211,16 +213,61 @@ private:
      */
     bool remove(const CustomSettingsPtr &settings);
 
+    /**
+     * Find the custom settings for the URL @p key in the index. If profiles
+     * are used, only the active profile is searched. The settings are
+     * returned in the order of the list and also if they do not define any
+     * custom setting.
+     *
+     * @param key       The normalized URL
+     *
+     * @returns the list of custom settings
+     */
+    QList<CustomSettingsPtr> findIndexedSettings(const QString &key) const;
+
+    /**
+     * Add custom settings to the index
+     */
+    void addToIndex(const CustomSettingsPtr &settings);
+
+    /**
+     * Rebuild the index from the list of custom settings
+     */
+    void rebuildIndex();
+
     /**
      * Read custom settings
      */
     void read();
 
     /**
-     * Write custom settings
+     * Read the custom settings from the XML file. Returns FALSE if the file could
+     * not be read.
+     */
+    bool readFile();
+
+    /**
+     * Read the custom settings from the snapshot @p stream. Returns FALSE if the
+     * snapshot is corrupted.
+     */
+    bool readSnapshot(QDataStream &stream);
+
+    /**
+     * Write the custom settings to the snapshot @p stream.
+     */
+    void writeSnapshot(QDataStream &stream);
+
+    /**
+     * Schedule writing the custom settings to the file
      */
     void write();
 
+    /**
+     * Write the custom settings to @p device. Returns FALSE if there are
+     * no custom settings.
+     */
+    bool writeFile(QIODevice *device);
+
     /**
      * Pointer to Smb4KCustomSettingsManagerPrivate class
      */
@@ -0,0 +1,100 @@
+/*
+    This class writes files deferred and atomically
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kdeferredwriter.h"
+#include "smb4knotification.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QFile>
+#include <QSaveFile>
+#include <QTimer>
+
+#define WRITE_DELAY 250
+
+class Smb4KDeferredWriterPrivate
+{
+public:
+    QString fileName;
+    Smb4KDeferredWriter::WriteFunction writeFunction;
+    QTimer timer;
+    bool dirty;
+};
+
+Smb4KDeferredWriter::Smb4KDeferredWriter(const QString &fileName, const WriteFunction &writeFunction, QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KDeferredWriterPrivate)
+{
+    d->fileName = fileName;
+    d->writeFunction = writeFunction;
+    d->dirty = false;
+
+    d->timer.setSingleShot(true);
+    d->timer.setInterval(WRITE_DELAY);
+
+    connect(&d->timer, &QTimer::timeout, this, &Smb4KDeferredWriter::flush);
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Smb4KDeferredWriter::slotAboutToQuit);
+}
+
+Smb4KDeferredWriter::~Smb4KDeferredWriter()
+{
+}
+
+void Smb4KDeferredWriter::scheduleWrite()
+{
+    d->dirty = true;
+
+    if (!d->timer.isActive()) {
+        d->timer.start();
+    }
+}
+
+void Smb4KDeferredWriter::flush()
+{
+    d->timer.stop();
+
+    if (!d->dirty) {
+        return;
+    }
+
+    d->dirty = false;
+
+    //
+    // The data is written to a temporary file that replaces the old file
+    // when it was completely written
+    //
+    QSaveFile saveFile(d->fileName);
+
+    if (saveFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        if (d->writeFunction(&saveFile)) {
+            if (saveFile.commit()) {
+                Q_EMIT fileWritten();
+            } else {
+                QFile xmlFile(d->fileName);
+                Smb4KNotification::openingFileFailed(xmlFile);
+            }
+        } else {
+            saveFile.cancelWriting();
+            QFile::remove(d->fileName);
+            Q_EMIT fileWritten();
+        }
+    } else {
+        QFile xmlFile(d->fileName);
+        Smb4KNotification::openingFileFailed(xmlFile);
+    }
+}
+
+bool Smb4KDeferredWriter::isDirty() const
+{
+    return d->dirty;
+}
+
+void Smb4KDeferredWriter::slotAboutToQuit()
+{
+    flush();
+}
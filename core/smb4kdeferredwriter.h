@@ -0,0 +1,99 @@
+/*
+    This class writes files deferred and atomically
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KDEFERREDWRITER_H
+#define SMB4KDEFERREDWRITER_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+
+// Qt includes
+#include <QObject>
+#include <QScopedPointer>
+
+// system includes
+#include <functional>
+
+// forward declarations
+class QIODevice;
+class Smb4KDeferredWriterPrivate;
+
+/**
+ * This class writes a file on behalf of a class that keeps its data in
+ * memory. Changes of the data only mark the file dirty. The file is
+ * written after a short delay, so that many changes in a row result in
+ * a single write. It is replaced atomically, so that it is never found
+ * half-written. Pending changes are written before the application quits.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.1.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KDeferredWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The function that writes the data to the device. It returns FALSE
+     * if there is no data. In that case, the file is removed.
+     */
+    using WriteFunction = std::function<bool(QIODevice *device)>;
+
+    /**
+     * Constructor
+     *
+     * @param fileName        The path of the file
+     *
+     * @param writeFunction   The function that writes the data
+     *
+     * @param parent          The parent object
+     */
+    Smb4KDeferredWriter(const QString &fileName, const WriteFunction &writeFunction, QObject *parent = nullptr);
+
+    /**
+     * Destructor
+     */
+    ~Smb4KDeferredWriter();
+
+    /**
+     * Mark the file dirty and schedule writing it.
+     */
+    void scheduleWrite();
+
+    /**
+     * Write the file now, if it is dirty.
+     */
+    void flush();
+
+    /**
+     * Returns TRUE if there are changes that were not written yet.
+     *
+     * @returns TRUE if the file is dirty.
+     */
+    bool isDirty() const;
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the file was written or removed.
+     */
+    void fileWritten();
+
+protected Q_SLOTS:
+    /**
+     * Called when the application is about to quit
+     */
+    void slotAboutToQuit();
+
+private:
+    /**
+     * Pointer to the Smb4KDeferredWriterPrivate class
+     */
+    const QScopedPointer<Smb4KDeferredWriterPrivate> d;
+};
+
+#endif
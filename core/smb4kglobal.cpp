@@ -12,8 +12,12 @@
 #include "smb4kglobalenums.h"
 #include "smb4kmounter.h"
 #include "smb4knotification.h"
+#include "smb4kresolver.h"
 #include "smb4ksynchronizer.h"
 
+// system includes
+#include <algorithm>
+
 // Qt includes
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
 #include <QApplicationStatic>
@@ -23,6 +27,7 @@
 #include <QDebug>
 #include <QDirIterator>
 #include <QEventLoop>
+#include <QHostAddress>
 #include <QRecursiveMutex>
 #include <QStandardPaths>
 #include <QTimer>
@@ -36,6 +41,37 @@
 Q_APPLICATION_STATIC(Smb4KGlobalPrivate, p);
 QRecursiveMutex mutex;
 
+//
+// Keys of the indexes. All look-ups are case insensitive, so the keys are
+// case folded.
+//
+static QString nameKey(const QString &name)
+{
+    return name.toCaseFolded();
+}
+
+static QString hostKey(const QString &hostName, const QString &workgroupName)
+{
+    return workgroupName.toCaseFolded() + QStringLiteral("/") + hostName.toCaseFolded();
+}
+
+static QString urlKey(const QUrl &url)
+{
+    return url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded();
+}
+
+//
+// The values of a QMultiHash are returned from the most recently to the least
+// recently inserted one. Return them in the order of the global lists.
+//
+template<typename T>
+static QList<T> indexValues(const QMultiHash<QString, T> &index, const QString &key)
+{
+    QList<T> values = index.values(key);
+    std::reverse(values.begin(), values.end());
+    return values;
+}
+
 const QList<WorkgroupPtr> &Smb4KGlobal::workgroupsList()
 {
     return p->workgroupsList;
@@ -47,12 +83,7 @@ WorkgroupPtr Smb4KGlobal::findWorkgroup(const QString &name)
 
     mutex.lock();
 
-    for (const WorkgroupPtr &w : std::as_const(p->workgroupsList)) {
-        if (QString::compare(w->workgroupName(), name, Qt::CaseInsensitive) == 0) {
-            workgroup = w;
-            break;
-        }
-    }
+    workgroup = p->workgroupsIndex.value(nameKey(name));
 
     mutex.unlock();
 
@@ -70,6 +101,7 @@ bool Smb4KGlobal::addWorkgroup(WorkgroupPtr workgroup)
 
         if (!findWorkgroup(workgroup->workgroupName())) {
             p->workgroupsList.append(workgroup);
+            p->workgroupsIndex.insert(nameKey(workgroup->workgroupName()), workgroup);
             added = true;
         }
 
@@ -110,25 +142,23 @@ bool Smb4KGlobal::removeWorkgroup(WorkgroupPtr workgroup)
     if (workgroup) {
         mutex.lock();
 
-        int index = p->workgroupsList.indexOf(workgroup);
-
-        if (index != -1) {
-            // The workgroup was found. Remove it.
-            p->workgroupsList.takeAt(index).clear();
-            removed = true;
-        } else {
-            // Try harder to find the workgroup.
-            WorkgroupPtr wg = findWorkgroup(workgroup->workgroupName());
+        //
+        // Always work with the workgroup that is in the list, because the
+        // one that was passed might be a copy.
+        //
+        WorkgroupPtr wg = findWorkgroup(workgroup->workgroupName());
 
-            if (wg) {
-                index = p->workgroupsList.indexOf(wg);
+        if (wg) {
+            int index = p->workgroupsList.indexOf(wg);
 
-                if (index != -1) {
-                    p->workgroupsList.takeAt(index).clear();
-                    removed = true;
-                }
+            if (index != -1) {
+                p->workgroupsIndex.remove(nameKey(wg->workgroupName()));
+                p->workgroupsList.takeAt(index).clear();
+                removed = true;
             }
+        }
 
+        if (wg != workgroup) {
             workgroup.clear();
         }
 
@@ -142,6 +172,8 @@ void Smb4KGlobal::clearWorkgroupsList()
 {
     mutex.lock();
 
+    p->workgroupsIndex.clear();
+
     while (!p->workgroupsList.isEmpty()) {
         p->workgroupsList.takeFirst().clear();
     }
@@ -160,11 +192,13 @@ HostPtr Smb4KGlobal::findHost(const QString &name, const QString &workgroup)
 
     mutex.lock();
 
-    for (const HostPtr &h : std::as_const(p->hostsList)) {
-        if ((workgroup.isEmpty() || QString::compare(h->workgroupName(), workgroup, Qt::CaseInsensitive) == 0)
-            && QString::compare(h->hostName(), name, Qt::CaseInsensitive) == 0) {
-            host = h;
-            break;
+    if (!workgroup.isEmpty()) {
+        host = p->hostsIndex.value(hostKey(name, workgroup));
+    } else {
+        QList<HostPtr> hosts = indexValues(p->hostNamesIndex, nameKey(name));
+
+        if (!hosts.isEmpty()) {
+            host = hosts.first();
         }
     }
 
@@ -184,6 +218,9 @@ bool Smb4KGlobal::addHost(HostPtr host)
 
         if (!findHost(host->hostName(), host->workgroupName())) {
             p->hostsList.append(host);
+            p->hostsIndex.insert(hostKey(host->hostName(), host->workgroupName()), host);
+            p->hostNamesIndex.insert(nameKey(host->hostName()), host);
+            p->workgroupMembersIndex.insert(nameKey(host->workgroupName()), host);
             added = true;
         }
 
@@ -224,25 +261,25 @@ bool Smb4KGlobal::removeHost(HostPtr host)
     if (host) {
         mutex.lock();
 
-        int index = p->hostsList.indexOf(host);
-
-        if (index != -1) {
-            // The host was found. Remove it.
-            p->hostsList.takeAt(index).clear();
-            removed = true;
-        } else {
-            // Try harder to find the host.
-            HostPtr h = findHost(host->hostName(), host->workgroupName());
+        //
+        // Always work with the host that is in the list, because the
+        // one that was passed might be a copy.
+        //
+        HostPtr h = p->hostsList.contains(host) ? host : findHost(host->hostName(), host->workgroupName());
 
-            if (h) {
-                index = p->hostsList.indexOf(h);
+        if (h) {
+            int index = p->hostsList.indexOf(h);
 
-                if (index != -1) {
-                    p->hostsList.takeAt(index).clear();
-                    removed = true;
-                }
+            if (index != -1) {
+                p->hostsIndex.remove(hostKey(h->hostName(), h->workgroupName()));
+                p->hostNamesIndex.remove(nameKey(h->hostName()), h);
+                p->workgroupMembersIndex.remove(nameKey(h->workgroupName()), h);
+                p->hostsList.takeAt(index).clear();
+                removed = true;
             }
+        }
 
+        if (h != host) {
             host.clear();
         }
 
@@ -256,6 +293,10 @@ void Smb4KGlobal::clearHostsList()
 {
     mutex.lock();
 
+    p->hostsIndex.clear();
+    p->hostNamesIndex.clear();
+    p->workgroupMembersIndex.clear();
+
     while (!p->hostsList.isEmpty()) {
         p->hostsList.takeFirst().clear();
     }
@@ -269,11 +310,7 @@ QList<HostPtr> Smb4KGlobal::workgroupMembers(WorkgroupPtr workgroup)
 
     mutex.lock();
 
-    for (const HostPtr &h : std::as_const(p->hostsList)) {
-        if (QString::compare(h->workgroupName(), workgroup->workgroupName(), Qt::CaseInsensitive) == 0) {
-            hosts << h;
-        }
-    }
+    hosts = indexValues(p->workgroupMembersIndex, nameKey(workgroup->workgroupName()));
 
     mutex.unlock();
 
@@ -291,12 +328,10 @@ SharePtr Smb4KGlobal::findShare(const QUrl &url, const QString &workgroup)
 
     mutex.lock();
 
-    for (const SharePtr &s : std::as_const(p->sharesList)) {
-        if (QString::compare(s->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                             url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                             Qt::CaseInsensitive)
-                == 0
-            && (workgroup.isEmpty() || QString::compare(s->workgroupName(), workgroup, Qt::CaseInsensitive) == 0)) {
+    const QList<SharePtr> shares = indexValues(p->sharesIndex, urlKey(url));
+
+    for (const SharePtr &s : shares) {
+        if (workgroup.isEmpty() || QString::compare(s->workgroupName(), workgroup, Qt::CaseInsensitive) == 0) {
             share = s;
             break;
         }
@@ -341,11 +376,13 @@ bool Smb4KGlobal::addShare(SharePtr share)
             // Add it
             //
             p->sharesList.append(share);
+            p->sharesIndex.insert(urlKey(share->url()), share);
+            p->sharedResourcesIndex.insert(hostKey(share->hostName(), share->workgroupName()), share);
             added = true;
         }
-    }
 
-    mutex.unlock();
+        mutex.unlock();
+    }
 
     return added;
 }
@@ -383,9 +420,17 @@ bool Smb4KGlobal::updateShare(SharePtr share)
             }
 
             //
-            // Update it
+            // Update it. The URL might differ in case, so update the index, too.
             //
+            QString oldKey = urlKey(existingShare->url());
+
             existingShare->update(share.data());
+
+            if (urlKey(existingShare->url()) != oldKey) {
+                p->sharesIndex.remove(oldKey, existingShare);
+                p->sharesIndex.insert(urlKey(existingShare->url()), existingShare);
+            }
+
             updated = true;
         }
 
@@ -404,25 +449,24 @@ bool Smb4KGlobal::removeShare(SharePtr share)
     if (share) {
         mutex.lock();
 
-        int index = p->sharesList.indexOf(share);
+        //
+        // Always work with the share that is in the list, because the
+        // one that was passed might be a copy.
+        //
+        SharePtr s = p->sharesList.contains(share) ? share : findShare(share->url(), share->workgroupName());
 
-        if (index != -1) {
-            // The share was found. Remove it.
-            p->sharesList.takeAt(index).clear();
-            removed = true;
-        } else {
-            // Try harder to find the share.
-            SharePtr s = findShare(share->url(), share->workgroupName());
+        if (s) {
+            int index = p->sharesList.indexOf(s);
 
-            if (s) {
-                index = p->sharesList.indexOf(s);
-
-                if (index != -1) {
-                    p->sharesList.takeAt(index).clear();
-                    removed = true;
-                }
+            if (index != -1) {
+                p->sharesIndex.remove(urlKey(s->url()), s);
+                p->sharedResourcesIndex.remove(hostKey(s->hostName(), s->workgroupName()), s);
+                p->sharesList.takeAt(index).clear();
+                removed = true;
             }
+        }
 
+        if (s != share) {
             share.clear();
         }
 
@@ -436,6 +480,9 @@ void Smb4KGlobal::clearSharesList()
 {
     mutex.lock();
 
+    p->sharesIndex.clear();
+    p->sharedResourcesIndex.clear();
+
     while (!p->sharesList.isEmpty()) {
         p->sharesList.takeFirst().clear();
     }
@@ -449,12 +496,7 @@ QList<SharePtr> Smb4KGlobal::sharedResources(HostPtr host)
 
     mutex.lock();
 
-    for (const SharePtr &s : std::as_const(p->sharesList)) {
-        if (QString::compare(s->hostName(), host->hostName(), Qt::CaseInsensitive) == 0
-            && QString::compare(s->workgroupName(), host->workgroupName(), Qt::CaseInsensitive) == 0) {
-            shares += s;
-        }
-    }
+    shares = indexValues(p->sharedResourcesIndex, hostKey(host->hostName(), host->workgroupName()));
 
     mutex.unlock();
 
@@ -473,11 +515,18 @@ SharePtr Smb4KGlobal::findShareByPath(const QString &path)
     mutex.lock();
 
     if (!path.isEmpty() && !p->mountedSharesList.isEmpty()) {
-        for (const SharePtr &s : std::as_const(p->mountedSharesList)) {
-            if (QString::compare(s->path(), path, Qt::CaseInsensitive) == 0
-                || (!s->isInaccessible() && QString::compare(s->canonicalPath(), path, Qt::CaseInsensitive) == 0)) {
-                share = s;
-                break;
+        QList<SharePtr> shares = indexValues(p->mountedSharesPathIndex, nameKey(path));
+
+        if (!shares.isEmpty()) {
+            share = shares.first();
+        } else {
+            shares = indexValues(p->mountedSharesCanonicalPathIndex, nameKey(path));
+
+            for (const SharePtr &s : std::as_const(shares)) {
+                if (!s->isInaccessible()) {
+                    share = s;
+                    break;
+                }
             }
         }
     }
@@ -494,14 +543,10 @@ QList<SharePtr> Smb4KGlobal::findShareByUrl(const QUrl &url)
     mutex.lock();
 
     if (!url.isEmpty() && url.isValid() && !p->mountedSharesList.isEmpty()) {
-        for (const SharePtr &s : std::as_const(p->mountedSharesList)) {
-            if (QString::compare(s->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                == 0) {
-                shares << s;
-                break;
-            }
+        QList<SharePtr> mountedShares = indexValues(p->mountedSharesUrlIndex, urlKey(url));
+
+        if (!mountedShares.isEmpty()) {
+            shares << mountedShares.first();
         }
     }
 
@@ -527,6 +572,26 @@ QList<SharePtr> Smb4KGlobal::findInaccessibleShares()
     return inaccessibleShares;
 }
 
+//
+// Maintain the indexes of the mounted shares
+//
+static void indexMountedShare(const SharePtr &share)
+{
+    QString canonicalPathKey = nameKey(share->canonicalPath());
+
+    p->mountedSharesUrlIndex.insert(urlKey(share->url()), share);
+    p->mountedSharesPathIndex.insert(nameKey(share->path()), share);
+    p->mountedSharesCanonicalPathIndex.insert(canonicalPathKey, share);
+    p->mountedSharesCanonicalPaths.insert(share.data(), canonicalPathKey);
+}
+
+static void unindexMountedShare(const SharePtr &share)
+{
+    p->mountedSharesUrlIndex.remove(urlKey(share->url()), share);
+    p->mountedSharesPathIndex.remove(nameKey(share->path()), share);
+    p->mountedSharesCanonicalPathIndex.remove(p->mountedSharesCanonicalPaths.take(share.data()), share);
+}
+
 bool Smb4KGlobal::addMountedShare(SharePtr share)
 {
     Q_ASSERT(share);
@@ -568,6 +633,7 @@ bool Smb4KGlobal::addMountedShare(SharePtr share)
             }
 
             p->mountedSharesList.append(share);
+            indexMountedShare(share);
             added = true;
 
             p->onlyForeignShares = true;
@@ -628,9 +694,12 @@ bool Smb4KGlobal::updateMountedShare(SharePtr share)
             }
 
             //
-            // Update share
+            // Update share. The mount point and its accessibility might
+            // have changed, so index it again.
             //
+            unindexMountedShare(mountedShare);
             mountedShare->setMountData(share.data());
+            indexMountedShare(mountedShare);
             updated = true;
         }
 
@@ -661,6 +730,7 @@ bool Smb4KGlobal::removeMountedShare(SharePtr share, bool takeOnly)
         int index = p->mountedSharesList.indexOf(share);
 
         if (index != -1) {
+            unindexMountedShare(share);
             p->mountedSharesList.takeAt(index);
             removed = true;
         } else {
@@ -670,6 +740,7 @@ bool Smb4KGlobal::removeMountedShare(SharePtr share, bool takeOnly)
                 index = p->mountedSharesList.indexOf(s);
 
                 if (index != -1) {
+                    unindexMountedShare(s);
                     p->mountedSharesList.takeAt(index).clear();
                     removed = true;
                 }
@@ -789,15 +860,28 @@ void Smb4KGlobal::wait(int time)
     loop.exec();
 }
 
-const QString Smb4KGlobal::findMacAddress(const QString &ipAddress)
+const QString Smb4KGlobal::findMacAddress(const QString &host)
 {
     QString macAddress, executable;
 
+    //
+    // Host names are resolved through the shared resolver cache
+    //
+    QHostAddress address(host);
+
+    if (address.isNull()) {
+        address = Smb4KResolver::self()->lookupIpAddress(host);
+
+        if (address.isNull()) {
+            return macAddress;
+        }
+    }
+
+    QString ipAddress = address.toString();
+
 #if defined(Q_OS_LINUX)
     executable = QStandardPaths::findExecutable(QStringLiteral("ip"));
 #elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
-    QHostAddress address(ipAddress);
-
     if (address.protocol() == QHostAddress::IPv4Protocol) {
         executable = QStandardPaths::findExecutable(QStringLiteral("arp"));
     } else if (address.protocol() == QHostAddress::IPv6Protocol) {
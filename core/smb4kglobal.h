@@ -419,11 +419,12 @@ SMB4KCORE_EXPORT void wait(int time);
 
 /**
  * Query the local arp cache and retrieve the MAC address for the given
- * IP address if available.
+ * IP address if available. If a host name is passed, it is resolved
+ * first.
  *
- * @param ipAddress     The IP addess of the server
+ * @param host          The IP addess or the host name of the server
  */
-SMB4KCORE_EXPORT const QString findMacAddress(const QString &ipAddress);
+SMB4KCORE_EXPORT const QString findMacAddress(const QString &host);
 
 /**
  * Construct the Wake-On-LAN magic sequence from the host's MAC address.
@@ -56,6 +56,20 @@ Smb4KGlobalPrivate::Smb4KGlobalPrivate()
 
 Smb4KGlobalPrivate::~Smb4KGlobalPrivate()
 {
+    //
+    // Clear the indexes
+    //
+    workgroupsIndex.clear();
+    hostsIndex.clear();
+    hostNamesIndex.clear();
+    workgroupMembersIndex.clear();
+    sharesIndex.clear();
+    sharedResourcesIndex.clear();
+    mountedSharesUrlIndex.clear();
+    mountedSharesPathIndex.clear();
+    mountedSharesCanonicalPathIndex.clear();
+    mountedSharesCanonicalPaths.clear();
+
     //
     // Clear the workgroup list
     //
@@ -15,6 +15,7 @@
 
 // Qt includes
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QObject>
@@ -61,6 +62,58 @@ public:
      */
     QList<QSharedPointer<Smb4KShare>> sharesList;
 
+    /**
+     * Index of the workgroups by their case folded name
+     */
+    QHash<QString, QSharedPointer<Smb4KWorkgroup>> workgroupsIndex;
+
+    /**
+     * Index of the hosts by their case folded workgroup and host name
+     */
+    QHash<QString, QSharedPointer<Smb4KHost>> hostsIndex;
+
+    /**
+     * Index of the hosts by their case folded host name
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KHost>> hostNamesIndex;
+
+    /**
+     * Index of the hosts by the case folded name of their workgroup
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KHost>> workgroupMembersIndex;
+
+    /**
+     * Index of the shares by their case folded URL
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KShare>> sharesIndex;
+
+    /**
+     * Index of the shares by the case folded workgroup and host name
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KShare>> sharedResourcesIndex;
+
+    /**
+     * Index of the mounted shares by their case folded URL
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KShare>> mountedSharesUrlIndex;
+
+    /**
+     * Index of the mounted shares by their case folded mount point
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KShare>> mountedSharesPathIndex;
+
+    /**
+     * Index of the mounted shares by their case folded canonical mount point
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KShare>> mountedSharesCanonicalPathIndex;
+
+    /**
+     * The keys under which the mounted shares are stored in the canonical
+     * path index. The canonical path cannot be determined anymore when the
+     * share was unmounted.
+     */
+    QHash<Smb4KShare *, QString> mountedSharesCanonicalPaths;
+
     /**
      * Boolean that is TRUE when only foreign shares
      * are in the list of mounted shares
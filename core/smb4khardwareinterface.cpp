@@ -9,7 +9,14 @@
 #include "smb4khardwareinterface.h"
 
 // system includes
+#include <fcntl.h>
 #include <unistd.h>
+#if defined(Q_OS_LINUX)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#endif
 
 // Qt includes
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
@@ -20,13 +27,18 @@
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusInterface>
-#include <QDBusReply>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusUnixFileDescriptor>
 #include <QDebug>
+#include <QHash>
 #include <QNetworkInterface>
+#include <QSet>
+#include <QSocketNotifier>
 #include <QString>
 #include <QStringList>
 #include <QTimer>
+#include <QtEndian>
 
 // KDE includes
 #include <Solid/Device>
@@ -46,15 +58,99 @@ public:
 #endif
     QScopedPointer<QDBusInterface> dbusInterface;
     QDBusUnixFileDescriptor fileDescriptor;
+    QDBusPendingCallWatcher *inhibitCallWatcher;
+    int inhibitCount;
     bool systemOnline;
     bool systemSleep;
     bool initialImportDone;
 #if defined(Q_OS_LINUX)
     QStringList udis;
+    int mountTableFd;
+    QScopedPointer<QSocketNotifier> mountTableNotifier;
+    QHash<int, QByteArray> mountTableLines;
+    QHash<int, Smb4KMountPointInfo> mountTable;
+    QHash<QString, int> mountTableIndex;
+    int netlinkFd;
+    QScopedPointer<QSocketNotifier> netlinkNotifier;
+    QSet<QString> runningInterfaces;
 #endif
     int timerId;
 };
 
+#if defined(Q_OS_LINUX)
+#define MOUNT_TABLE_FILE "/proc/self/mountinfo"
+
+//
+// Decode the octal escape sequences the kernel uses for white space
+// and backslashes in the mount table
+//
+static QString decodeMountTableField(const QByteArray &field)
+{
+    if (!field.contains('\\')) {
+        return QString::fromLocal8Bit(field);
+    }
+
+    QByteArray decoded;
+    decoded.reserve(field.size());
+
+    for (int i = 0; i < field.size(); ++i) {
+        if (field.at(i) == '\\' && i + 3 < field.size()) {
+            bool ok = false;
+            int character = field.mid(i + 1, 3).toInt(&ok, 8);
+
+            if (ok) {
+                decoded.append(static_cast<char>(character));
+                i += 3;
+                continue;
+            }
+        }
+
+        decoded.append(field.at(i));
+    }
+
+    return QString::fromLocal8Bit(decoded);
+}
+
+//
+// Parse a line of the mount table. Only the lines of CIFS/SMB3 mounts are
+// parsed, all others are skipped as early as possible.
+//
+static bool parseMountTableLine(const QByteArray &line, int *mountId, Smb4KMountPointInfo *info)
+{
+    if (!line.contains(" - cifs ") && !line.contains(" - smb3 ")) {
+        return false;
+    }
+
+    // Format: ID parentID major:minor root mountpoint options [optional fields] - type source superoptions
+    QList<QByteArray> fields = line.split(' ');
+    int separator = fields.indexOf(QByteArray("-"));
+
+    if (separator < 6 || fields.size() < separator + 4) {
+        return false;
+    }
+
+    bool ok = false;
+    *mountId = fields.at(0).toInt(&ok);
+
+    if (!ok) {
+        return false;
+    }
+
+    info->mountPoint = decodeMountTableField(fields.at(4));
+    info->fileSystemType = QString::fromLatin1(fields.at(separator + 1));
+    info->mountedFrom = decodeMountTableField(fields.at(separator + 2));
+    info->mountOptions.clear();
+
+    const QList<QByteArray> options = fields.at(5).split(',') + fields.at(separator + 3).split(',');
+
+    for (const QByteArray &option : options) {
+        info->mountOptions << decodeMountTableField(option);
+    }
+
+    return true;
+}
+#endif
+
 class Smb4KHardwareInterfaceStatic
 {
 public:
@@ -70,9 +166,51 @@ Smb4KHardwareInterface::Smb4KHardwareInterface(QObject *parent)
     d->systemOnline = false;
     d->systemSleep = false;
     d->initialImportDone = false;
-    d->fileDescriptor.setFileDescriptor(-1);
+    d->inhibitCallWatcher = nullptr;
+    d->inhibitCount = 0;
     d->timerId = -1;
 
+#if defined(Q_OS_LINUX)
+    //
+    // Watch the kernel's mount table. The kernel signals changes by POLLPRI,
+    // which the socket notifier reports as an exception.
+    //
+    d->mountTableFd = open(MOUNT_TABLE_FILE, O_RDONLY | O_CLOEXEC);
+
+    if (d->mountTableFd != -1) {
+        d->mountTableNotifier.reset(new QSocketNotifier(d->mountTableFd, QSocketNotifier::Exception));
+        connect(d->mountTableNotifier.data(), &QSocketNotifier::activated, this, &Smb4KHardwareInterface::slotMountTableChanged);
+    }
+
+    //
+    // Listen to the kernel's notifications about changed network interfaces
+    // and addresses, so that the online state does not need to be polled.
+    //
+    d->netlinkFd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+
+    if (d->netlinkFd != -1) {
+        struct sockaddr_nl address = {};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+        if (bind(d->netlinkFd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) == 0) {
+            d->netlinkNotifier.reset(new QSocketNotifier(d->netlinkFd, QSocketNotifier::Read));
+            connect(d->netlinkNotifier.data(), &QSocketNotifier::activated, this, &Smb4KHardwareInterface::slotNetworkChanged);
+
+            const QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
+
+            for (const QNetworkInterface &networkInterface : interfaces) {
+                if (networkInterface.flags().testFlag(QNetworkInterface::IsRunning) && !networkInterface.flags().testFlag(QNetworkInterface::IsLoopBack)) {
+                    d->runningInterfaces << networkInterface.name();
+                }
+            }
+        } else {
+            close(d->netlinkFd);
+            d->netlinkFd = -1;
+        }
+    }
+#endif
+
     //
     // Set up the DBUS interface
     //
@@ -110,16 +248,20 @@ Smb4KHardwareInterface::Smb4KHardwareInterface(QObject *parent)
     //
     QTimer::singleShot(0, [&]() {
 #if defined(Q_OS_LINUX)
-        QList<Solid::Device> allDevices = Solid::Device::allDevices();
-
-        for (const Solid::Device &device : std::as_const(allDevices)) {
-            const Solid::DeviceInterface *iface = device.asDeviceInterface(Solid::DeviceInterface::NetworkShare);
-            const Solid::NetworkShare *networkShare = qobject_cast<const Solid::NetworkShare *>(iface);
-
-            if (networkShare && (networkShare->type() == Solid::NetworkShare::Cifs || networkShare->type() == Solid::NetworkShare::Smb3)) {
-                d->udis << device.udi();
-                QString mountpoint = device.udi().section(QStringLiteral(":"), -1, -1).trimmed();
-                Q_EMIT networkShareAdded(mountpoint);
+        if (d->mountTableFd != -1) {
+            readMountTable();
+        } else {
+            QList<Solid::Device> allDevices = Solid::Device::allDevices();
+
+            for (const Solid::Device &device : std::as_const(allDevices)) {
+                const Solid::DeviceInterface *iface = device.asDeviceInterface(Solid::DeviceInterface::NetworkShare);
+                const Solid::NetworkShare *networkShare = qobject_cast<const Solid::NetworkShare *>(iface);
+
+                if (networkShare && (networkShare->type() == Solid::NetworkShare::Cifs || networkShare->type() == Solid::NetworkShare::Smb3)) {
+                    d->udis << device.udi();
+                    QString mountpoint = device.udi().section(QStringLiteral(":"), -1, -1).trimmed();
+                    Q_EMIT networkShareAdded(mountpoint);
+                }
             }
         }
 #elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
@@ -133,17 +275,31 @@ Smb4KHardwareInterface::Smb4KHardwareInterface(QObject *parent)
         }
 #endif
         d->initialImportDone = true;
-        d->timerId = startTimer(1000);
+        startPolling();
     });
 
 #if defined(Q_OS_LINUX)
-    connect(Solid::DeviceNotifier::instance(), &Solid::DeviceNotifier::deviceAdded, this, &Smb4KHardwareInterface::slotDeviceAdded);
-    connect(Solid::DeviceNotifier::instance(), &Solid::DeviceNotifier::deviceRemoved, this, &Smb4KHardwareInterface::slotDeviceRemoved);
+    // Solid is only used, if the mount table cannot be watched
+    if (d->mountTableFd == -1) {
+        connect(Solid::DeviceNotifier::instance(), &Solid::DeviceNotifier::deviceAdded, this, &Smb4KHardwareInterface::slotDeviceAdded);
+        connect(Solid::DeviceNotifier::instance(), &Solid::DeviceNotifier::deviceRemoved, this, &Smb4KHardwareInterface::slotDeviceRemoved);
+    }
 #endif
 }
 
 Smb4KHardwareInterface::~Smb4KHardwareInterface()
 {
+#if defined(Q_OS_LINUX)
+    if (d->mountTableFd != -1) {
+        d->mountTableNotifier.reset();
+        close(d->mountTableFd);
+    }
+
+    if (d->netlinkFd != -1) {
+        d->netlinkNotifier.reset();
+        close(d->netlinkFd);
+    }
+#endif
 }
 
 Smb4KHardwareInterface *Smb4KHardwareInterface::self()
@@ -158,34 +314,44 @@ bool Smb4KHardwareInterface::isOnline() const
 
 void Smb4KHardwareInterface::inhibit()
 {
-    if (d->fileDescriptor.isValid()) {
+    d->inhibitCount++;
+
+    //
+    // The lock is already held or it was requested
+    //
+    if (d->fileDescriptor.isValid() || d->inhibitCallWatcher) {
         return;
     }
 
-    if (d->dbusInterface->isValid()) {
+    if (d->dbusInterface && d->dbusInterface->isValid()) {
         QVariantList args;
         args << QStringLiteral("shutdown:sleep:idle");
         args << QStringLiteral("Smb4K");
         args << QStringLiteral("Mounting or unmounting in progress");
         args << QStringLiteral("block");
 
-        QDBusReply<QDBusUnixFileDescriptor> descriptor = d->dbusInterface->callWithArgumentList(QDBus::Block, QStringLiteral("Inhibit"), args);
+        QDBusPendingCall call = d->dbusInterface->asyncCallWithArgumentList(QStringLiteral("Inhibit"), args);
 
-        if (descriptor.isValid()) {
-            d->fileDescriptor = descriptor.value();
-        }
+        d->inhibitCallWatcher = new QDBusPendingCallWatcher(call, this);
+        connect(d->inhibitCallWatcher, &QDBusPendingCallWatcher::finished, this, &Smb4KHardwareInterface::slotInhibitCallFinished);
     }
 }
 
 void Smb4KHardwareInterface::uninhibit()
 {
-    if (!d->fileDescriptor.isValid()) {
+    if (d->inhibitCount == 0) {
         return;
     }
 
-    if (d->dbusInterface->isValid()) {
-        close(d->fileDescriptor.fileDescriptor());
-        d->fileDescriptor.setFileDescriptor(-1);
+    d->inhibitCount--;
+
+    //
+    // Closing the file descriptor releases the lock. If the lock was
+    // requested, but not received yet, it is released when the reply
+    // arrives.
+    //
+    if (d->inhibitCount == 0 && d->fileDescriptor.isValid()) {
+        d->fileDescriptor = QDBusUnixFileDescriptor();
     }
 }
 
@@ -210,6 +376,19 @@ void Smb4KHardwareInterface::checkOnlineState(bool emitSignal)
     }
 }
 
+void Smb4KHardwareInterface::startPolling()
+{
+#if defined(Q_OS_LINUX)
+    // The online state is only polled, if the network cannot be watched.
+    if (d->netlinkFd != -1) {
+        checkOnlineState();
+        return;
+    }
+#endif
+
+    d->timerId = startTimer(1000);
+}
+
 bool Smb4KHardwareInterface::initialImportDone() const
 {
     return d->initialImportDone;
@@ -219,8 +398,12 @@ QStringList Smb4KHardwareInterface::allMountPoints() const
 {
     QStringList mountPoints;
 #if defined(Q_OS_LINUX)
-    for (const QString &udi : std::as_const(d->udis)) {
-        mountPoints << udi.section(QStringLiteral(":"), -1, -1).trimmed();
+    if (d->mountTableFd != -1) {
+        mountPoints = d->mountTableIndex.keys();
+    } else {
+        for (const QString &udi : std::as_const(d->udis)) {
+            mountPoints << udi.section(QStringLiteral(":"), -1, -1).trimmed();
+        }
     }
 #elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
     mountPoints = d->mountPoints;
@@ -228,6 +411,23 @@ QStringList Smb4KHardwareInterface::allMountPoints() const
     return mountPoints;
 }
 
+bool Smb4KHardwareInterface::mountPointInfo(const QString &mountPoint, Smb4KMountPointInfo *info) const
+{
+#if defined(Q_OS_LINUX)
+    auto it = d->mountTableIndex.constFind(mountPoint);
+
+    if (it != d->mountTableIndex.constEnd()) {
+        *info = d->mountTable.value(*it);
+        return true;
+    }
+#else
+    Q_UNUSED(mountPoint);
+    Q_UNUSED(info);
+#endif
+
+    return false;
+}
+
 void Smb4KHardwareInterface::timerEvent(QTimerEvent *event)
 {
     Q_UNUSED(event);
@@ -301,16 +501,237 @@ void Smb4KHardwareInterface::slotDeviceRemoved(const QString &udi)
         d->udis.removeOne(udi);
     }
 }
+
+void Smb4KHardwareInterface::slotMountTableChanged()
+{
+    readMountTable();
+}
+
+void Smb4KHardwareInterface::slotNetworkChanged()
+{
+    QHash<QString, bool> interfaces;
+    QList<QNetworkAddressEntry> addedAddresses, removedAddresses;
+
+    alignas(struct nlmsghdr) char buffer[8192];
+    ssize_t length = 0;
+
+    while ((length = recv(d->netlinkFd, buffer, sizeof(buffer), 0)) > 0) {
+        for (struct nlmsghdr *header = reinterpret_cast<struct nlmsghdr *>(buffer); NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+            switch (header->nlmsg_type) {
+            case RTM_NEWLINK:
+            case RTM_DELLINK: {
+                struct ifinfomsg *info = static_cast<struct ifinfomsg *>(NLMSG_DATA(header));
+
+                if (info->ifi_flags & IFF_LOOPBACK) {
+                    break;
+                }
+
+                // The interface name is passed along, because a removed
+                // interface cannot be looked up anymore.
+                QString interfaceName;
+                int attributesLength = IFLA_PAYLOAD(header);
+
+                for (struct rtattr *attribute = IFLA_RTA(info); RTA_OK(attribute, attributesLength); attribute = RTA_NEXT(attribute, attributesLength)) {
+                    if (attribute->rta_type == IFLA_IFNAME) {
+                        interfaceName = QString::fromLocal8Bit(static_cast<const char *>(RTA_DATA(attribute)));
+                        break;
+                    }
+                }
+
+                // The last reported state of the interface counts
+                if (!interfaceName.isEmpty()) {
+                    interfaces.insert(interfaceName, header->nlmsg_type == RTM_NEWLINK && (info->ifi_flags & IFF_RUNNING));
+                }
+
+                break;
+            }
+            case RTM_NEWADDR:
+            case RTM_DELADDR: {
+                struct ifaddrmsg *info = static_cast<struct ifaddrmsg *>(NLMSG_DATA(header));
+                QHostAddress address;
+                int attributesLength = IFA_PAYLOAD(header);
+
+                // Prefer the local address over the address of the peer
+                for (struct rtattr *attribute = IFA_RTA(info); RTA_OK(attribute, attributesLength); attribute = RTA_NEXT(attribute, attributesLength)) {
+                    if (attribute->rta_type != IFA_LOCAL && (attribute->rta_type != IFA_ADDRESS || !address.isNull())) {
+                        continue;
+                    }
+
+                    if (info->ifa_family == AF_INET) {
+                        address.setAddress(qFromBigEndian<quint32>(RTA_DATA(attribute)));
+                    } else if (info->ifa_family == AF_INET6) {
+                        address.setAddress(static_cast<const quint8 *>(RTA_DATA(attribute)));
+                    }
+                }
+
+                if (address.isNull() || address.isLoopback()) {
+                    break;
+                }
+
+                QNetworkAddressEntry entry;
+                entry.setIp(address);
+                entry.setPrefixLength(info->ifa_prefixlen);
+
+                if (header->nlmsg_type == RTM_NEWADDR) {
+                    addedAddresses << entry;
+                } else {
+                    removedAddresses << entry;
+                }
+
+                break;
+            }
+            default: {
+                break;
+            }
+            }
+        }
+    }
+
+    //
+    // The addresses of an interface that went down cannot be used anymore,
+    // even though they are still assigned to it. Report them as removed,
+    // so that only the servers in their subnets are affected. Report them
+    // as added again when the interface went up.
+    //
+    for (auto it = interfaces.constBegin(); it != interfaces.constEnd(); ++it) {
+        if (it.value() == d->runningInterfaces.contains(it.key())) {
+            continue;
+        }
+
+        const QList<QNetworkAddressEntry> entries = QNetworkInterface::interfaceFromName(it.key()).addressEntries();
+
+        for (const QNetworkAddressEntry &entry : entries) {
+            if (entry.ip().isLoopback()) {
+                continue;
+            }
+
+            if (it.value()) {
+                addedAddresses << entry;
+            } else {
+                removedAddresses << entry;
+            }
+        }
+
+        if (it.value()) {
+            d->runningInterfaces << it.key();
+        } else {
+            d->runningInterfaces.remove(it.key());
+        }
+    }
+
+    if (!addedAddresses.isEmpty() || !removedAddresses.isEmpty()) {
+        Q_EMIT networkAddressesChanged(addedAddresses, removedAddresses);
+    }
+
+    // The system might have gone online or offline
+    if (!d->systemSleep) {
+        checkOnlineState();
+    }
+}
+
+void Smb4KHardwareInterface::readMountTable()
+{
+    //
+    // Read the whole mount table. The file has to be read from the start
+    // every time, so that the kernel resets the change notification.
+    //
+    QByteArray contents;
+    char buffer[16384];
+    ssize_t bytesRead = 0;
+
+    lseek(d->mountTableFd, 0, SEEK_SET);
+
+    while ((bytesRead = read(d->mountTableFd, buffer, sizeof(buffer))) > 0) {
+        contents.append(buffer, bytesRead);
+    }
+
+    QHash<int, QByteArray> mountTableLines;
+    QHash<int, Smb4KMountPointInfo> mountTable;
+    const QList<QByteArray> lines = contents.split('\n');
+
+    for (const QByteArray &line : lines) {
+        Smb4KMountPointInfo info;
+        int mountId = line.left(line.indexOf(' ')).toInt();
+
+        // Lines that did not change since the last read are not parsed again
+        if (d->mountTableLines.contains(mountId) && d->mountTableLines.value(mountId) == line) {
+            mountTableLines.insert(mountId, line);
+            mountTable.insert(mountId, d->mountTable.value(mountId));
+            continue;
+        }
+
+        if (parseMountTableLine(line, &mountId, &info)) {
+            mountTableLines.insert(mountId, line);
+            mountTable.insert(mountId, info);
+        }
+    }
+
+    QStringList removedMountPoints, addedMountPoints;
+
+    for (auto it = d->mountTable.constBegin(); it != d->mountTable.constEnd(); ++it) {
+        if (!mountTable.contains(it.key())) {
+            removedMountPoints << it->mountPoint;
+        }
+    }
+
+    for (auto it = mountTable.constBegin(); it != mountTable.constEnd(); ++it) {
+        if (!d->mountTable.contains(it.key())) {
+            addedMountPoints << it->mountPoint;
+        }
+    }
+
+    //
+    // Update the snapshot before the signals are emitted, so that the
+    // receivers can look the mount points up
+    //
+    d->mountTableLines = mountTableLines;
+    d->mountTable = mountTable;
+    d->mountTableIndex.clear();
+
+    for (auto it = d->mountTable.constBegin(); it != d->mountTable.constEnd(); ++it) {
+        d->mountTableIndex.insert(it->mountPoint, it.key());
+    }
+
+    for (const QString &mountPoint : std::as_const(removedMountPoints)) {
+        Q_EMIT networkShareRemoved(mountPoint);
+    }
+
+    for (const QString &mountPoint : std::as_const(addedMountPoints)) {
+        Q_EMIT networkShareAdded(mountPoint);
+    }
+}
 #endif
 
+void Smb4KHardwareInterface::slotInhibitCallFinished(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<QDBusUnixFileDescriptor> reply = *watcher;
+
+    if (reply.isError()) {
+        qDebug() << "Taking the inhibitor lock failed:" << reply.error().message();
+    } else if (d->inhibitCount != 0) {
+        d->fileDescriptor = reply.value();
+    }
+
+    watcher->deleteLater();
+    d->inhibitCallWatcher = nullptr;
+}
+
 void Smb4KHardwareInterface::slotSystemSleep(bool sleep)
 {
-    inhibit();
+    //
+    // No inhibitor lock is taken here. The sleep was already initiated
+    // when this signal arrives, so a lock that is only granted
+    // asynchronously would not delay it.
+    //
     d->systemSleep = sleep;
 
+    Q_EMIT systemSleepStateChanged(d->systemSleep);
+
     if (d->systemSleep) {
-        killTimer(d->timerId);
-        d->timerId = -1;
+        if (d->timerId != -1) {
+            killTimer(d->timerId);
+            d->timerId = -1;
+        }
         // The system will recover after a shutdown completely, so we
         // do not have the trigger any unmounts by emitting a signal
         // here. However, we will awake from a sleep later, so some things
@@ -318,8 +739,6 @@ void Smb4KHardwareInterface::slotSystemSleep(bool sleep)
         // signal.
         d->systemOnline = false;
     } else {
-        d->timerId = startTimer(1000);
+        startPolling();
     }
-
-    uninhibit();
 }
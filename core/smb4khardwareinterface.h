@@ -13,12 +13,24 @@
 #include "smb4kglobal.h"
 
 // Qt includes
+#include <QNetworkAddressEntry>
 #include <QObject>
 #include <QScopedPointer>
 #include <QUrl>
 
+class QDBusPendingCallWatcher;
 class Smb4KHardwareInterfacePrivate;
 
+/**
+ * The information about a mounted network share
+ */
+struct Smb4KMountPointInfo {
+    QString mountPoint;
+    QString mountedFrom;
+    QString fileSystemType;
+    QStringList mountOptions;
+};
+
 /**
  * This class provides an interface to the computer's hardware.
  * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
@@ -56,12 +68,15 @@ public:
     bool isOnline() const;
 
     /**
-     * Inhibit shutdown and sleep.
+     * Inhibit shutdown and sleep. The inhibitor lock is taken in the
+     * background, so this function returns immediately. Calls may be
+     * nested, each one must be matched by a call to uninhibit().
      */
     void inhibit();
 
     /**
-     * Uninhibit shutdown and sleep.
+     * Uninhibit shutdown and sleep. The inhibitor lock is released when
+     * the last call to inhibit() was matched.
      */
     void uninhibit();
 
@@ -81,6 +96,20 @@ public:
      */
     QStringList allMountPoints() const;
 
+    /**
+     * This function returns the information about the Samba share mounted
+     * at @p mountPoint, as it is found in the kernel's mount table. It is
+     * taken from a snapshot that is kept up to date, so the mount table
+     * is not read. This is only supported on Linux.
+     *
+     * @param mountPoint    The mount point
+     *
+     * @param info          The information about the mount
+     *
+     * @returns TRUE if the mount point was found.
+     */
+    bool mountPointInfo(const QString &mountPoint, Smb4KMountPointInfo *info) const;
+
 protected:
     /**
      * Reimplemented from QObject to check the online state and to check
@@ -110,6 +139,28 @@ Q_SIGNALS:
      */
     void onlineStateChanged(bool online);
 
+    /**
+     * This signal is emitted when the system is about to enter a sleep
+     * state or was woken up. When the system was woken up, it is emitted
+     * before the online state is checked again.
+     *
+     * @param sleep     TRUE if the system is about to sleep and FALSE
+     *                  if it was woken up
+     */
+    void systemSleepStateChanged(bool sleep);
+
+    /**
+     * This signal is emitted when IP addresses were assigned to or removed
+     * from the network interfaces. When a network interface went up or
+     * down, its addresses are reported as added or removed as well, since
+     * they became usable or unusable. Loopback addresses are not reported.
+     * It is only emitted on Linux.
+     *
+     * @param added         The new addresses with their prefix lengths
+     * @param removed       The removed addresses with their prefix lengths
+     */
+    void networkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed);
+
 protected Q_SLOTS:
 #if defined(Q_OS_LINUX)
     /**
@@ -123,6 +174,17 @@ protected Q_SLOTS:
      * @param udi     the device UDI
      */
     void slotDeviceRemoved(const QString &udi);
+
+    /**
+     * This slot is called when the kernel's mount table changed.
+     */
+    void slotMountTableChanged();
+
+    /**
+     * This slot is called when the kernel reported changes of the network
+     * interfaces or addresses.
+     */
+    void slotNetworkChanged();
 #endif
 
     /**
@@ -134,6 +196,14 @@ protected Q_SLOTS:
      */
     void slotSystemSleep(bool sleep);
 
+    /**
+     * This slot is called when the request for the inhibitor lock
+     * returned.
+     *
+     * @param watcher   The watcher of the pending call
+     */
+    void slotInhibitCallFinished(QDBusPendingCallWatcher *watcher);
+
 private:
     /**
      * Check the online state and emit the @see onlineStateChanged() accordingly, if
@@ -141,6 +211,22 @@ private:
      */
     void checkOnlineState(bool emitSignal = true);
 
+    /**
+     * Start polling the online state and - on BSD - the mounted shares.
+     * On Linux, the online state is not polled if the network can be
+     * watched.
+     */
+    void startPolling();
+
+#if defined(Q_OS_LINUX)
+    /**
+     * Read the kernel's mount table, update the snapshot of the mounted
+     * Samba shares and emit the networkShareAdded() and networkShareRemoved()
+     * signals for the changes.
+     */
+    void readMountTable();
+#endif
+
     /**
      * Pointer to private class
      */
@@ -7,10 +7,12 @@
 
 // application specific includes
 #include "smb4khomesshareshandler.h"
+#include "smb4kdeferredwriter.h"
 #include "smb4knotification.h"
 #include "smb4kprofilemanager.h"
 #include "smb4ksettings.h"
 #include "smb4kshare.h"
+#include "smb4ksnapshotcache.h"
 
 // Qt includes
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
@@ -18,6 +20,7 @@
 #else
 #include <qapplicationstatic.h>
 #endif
+#include <QDataStream>
 #include <QFile>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -102,6 +105,8 @@ class Smb4KHomesSharesHandlerPrivate
 {
 public:
     QList<Smb4KHomesUsers *> homesUsers;
+    Smb4KDeferredWriter *writer;
+    QScopedPointer<Smb4KSnapshotCache> snapshot;
 };
 
 class Smb4KHomesSharesHandlerStatic
@@ -125,11 +130,27 @@ Smb4KHomesSharesHandler::Smb4KHomesSharesHandler(QObject *parent)
         dir.mkpath(path);
     }
 
+    d->writer = new Smb4KDeferredWriter(path + QDir::separator() + QStringLiteral("homes_shares.xml"),
+                                        [this](QIODevice *device) {
+                                            return writeFile(device);
+                                        },
+                                        this);
+
+    d->snapshot.reset(new Smb4KSnapshotCache(path + QDir::separator() + QStringLiteral("homes_shares.xml"), 1));
+
+    connect(d->writer, &Smb4KDeferredWriter::fileWritten, this, [this]() {
+        d->snapshot->save([this](QDataStream &stream) {
+            writeSnapshot(stream);
+        });
+    });
+
     readUserNames();
 }
 
 Smb4KHomesSharesHandler::~Smb4KHomesSharesHandler()
 {
+    d->writer->flush();
+
     while (!d->homesUsers.isEmpty()) {
         delete d->homesUsers.takeFirst();
     }
@@ -195,6 +216,31 @@ void Smb4KHomesSharesHandler::addHomesUsers(const SharePtr &share, const QString
 
 void Smb4KHomesSharesHandler::readUserNames()
 {
+    //
+    // Load the snapshot of the file, if it is up to date. Otherwise, read
+    // the file and take a new snapshot.
+    //
+    bool snapshotLoaded = d->snapshot->load([this](QDataStream &stream) {
+        return readSnapshot(stream);
+    });
+
+    if (!snapshotLoaded) {
+        while (!d->homesUsers.isEmpty()) {
+            delete d->homesUsers.takeFirst();
+        }
+
+        if (readFile()) {
+            d->snapshot->save([this](QDataStream &stream) {
+                writeSnapshot(stream);
+            });
+        }
+    }
+}
+
+bool Smb4KHomesSharesHandler::readFile()
+{
+    bool success = true;
+
     // Locate the XML file.
     QFile xmlFile(dataLocation() + QDir::separator() + QStringLiteral("homes_shares.xml"));
 
@@ -298,52 +344,87 @@ void Smb4KHomesSharesHandler::readUserNames()
 
         if (xmlReader.hasError()) {
             Smb4KNotification::readingFileFailed(xmlFile, xmlReader.errorString());
+            success = false;
         }
     } else {
         if (xmlFile.exists()) {
             Smb4KNotification::openingFileFailed(xmlFile);
+            success = false;
         }
     }
+    return success;
+}
+
+bool Smb4KHomesSharesHandler::readSnapshot(QDataStream &stream)
+{
+    quint32 count = 0;
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString profile, url, workgroupName;
+        QStringList userList;
+
+        stream >> profile >> url >> workgroupName >> userList;
+
+        Smb4KHomesUsers *users = new Smb4KHomesUsers();
+        users->setProfile(profile);
+        users->setUrl(QUrl(url));
+        users->setWorkgroupName(workgroupName);
+        users->setUserList(userList);
+
+        d->homesUsers << users;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+void Smb4KHomesSharesHandler::writeSnapshot(QDataStream &stream)
+{
+    stream << quint32(d->homesUsers.size());
+
+    for (const Smb4KHomesUsers *users : std::as_const(d->homesUsers)) {
+        stream << users->profile() << users->url().toString(QUrl::RemoveUserInfo | QUrl::StripTrailingSlash) << users->workgroupName() << users->userList();
+    }
 }
 
 void Smb4KHomesSharesHandler::writeUserNames()
+{
+    d->writer->scheduleWrite();
+}
+
+bool Smb4KHomesSharesHandler::writeFile(QIODevice *device)
 {
     // FIXME: Use the workgroup at all? We really only need the URL.
-    QFile xmlFile(dataLocation() + QDir::separator() + QStringLiteral("homes_shares.xml"));
+    if (d->homesUsers.isEmpty()) {
+        return false;
+    }
 
-    if (!d->homesUsers.isEmpty()) {
-        if (xmlFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QXmlStreamWriter xmlWriter(&xmlFile);
-            xmlWriter.setAutoFormatting(true);
-            xmlWriter.writeStartDocument();
-            xmlWriter.writeStartElement(QStringLiteral("homes_shares"));
-            xmlWriter.writeAttribute(QStringLiteral("version"), QStringLiteral("2.0"));
-
-            for (Smb4KHomesUsers *users : std::as_const(d->homesUsers)) {
-                xmlWriter.writeStartElement(QStringLiteral("homes_share"));
-                xmlWriter.writeAttribute(QStringLiteral("url"), users->url().toString(QUrl::RemoveUserInfo | QUrl::StripTrailingSlash));
-                xmlWriter.writeAttribute(QStringLiteral("profile"), users->profile());
-                xmlWriter.writeTextElement(QStringLiteral("workgroup"), users->workgroupName());
-                xmlWriter.writeStartElement(QStringLiteral("users"));
-
-                QStringList userList = users->userList();
-
-                for (const QString &user : std::as_const(userList)) {
-                    xmlWriter.writeTextElement(QStringLiteral("user"), user);
-                }
+    QXmlStreamWriter xmlWriter(device);
+    xmlWriter.setAutoFormatting(true);
+    xmlWriter.writeStartDocument();
+    xmlWriter.writeStartElement(QStringLiteral("homes_shares"));
+    xmlWriter.writeAttribute(QStringLiteral("version"), QStringLiteral("2.0"));
 
-                xmlWriter.writeEndElement();
-                xmlWriter.writeEndElement();
-            }
+    for (Smb4KHomesUsers *users : std::as_const(d->homesUsers)) {
+        xmlWriter.writeStartElement(QStringLiteral("homes_share"));
+        xmlWriter.writeAttribute(QStringLiteral("url"), users->url().toString(QUrl::RemoveUserInfo | QUrl::StripTrailingSlash));
+        xmlWriter.writeAttribute(QStringLiteral("profile"), users->profile());
+        xmlWriter.writeTextElement(QStringLiteral("workgroup"), users->workgroupName());
+        xmlWriter.writeStartElement(QStringLiteral("users"));
 
-            xmlWriter.writeEndDocument();
-            xmlFile.close();
-        } else {
-            Smb4KNotification::openingFileFailed(xmlFile);
+        QStringList userList = users->userList();
+
+        for (const QString &user : std::as_const(userList)) {
+            xmlWriter.writeTextElement(QStringLiteral("user"), user);
         }
-    } else {
-        xmlFile.remove();
+
+        xmlWriter.writeEndElement();
+        xmlWriter.writeEndElement();
     }
+
+    xmlWriter.writeEndDocument();
+
+    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -20,6 +20,8 @@
 #include <QStringList>
 
 // forward declarations
+class QDataStream;
+class QIODevice;
 class Smb4KAuthInfo;
 class Smb4KHomesUsers;
 class Smb4KHomesSharesHandlerPrivate;
@@ -94,10 +96,33 @@ private:
     void readUserNames();
 
     /**
-     * This function writes the homes user entries to the disk.
+     * This function reads the homes user entries from the XML file. It
+     * returns FALSE if the file could not be read.
+     */
+    bool readFile();
+
+    /**
+     * This function reads the homes user entries from the snapshot @p stream.
+     * It returns FALSE if the snapshot is corrupted.
+     */
+    bool readSnapshot(QDataStream &stream);
+
+    /**
+     * This function writes the homes user entries to the snapshot @p stream.
+     */
+    void writeSnapshot(QDataStream &stream);
+
+    /**
+     * This function schedules writing the homes user entries to the disk.
      */
     void writeUserNames();
 
+    /**
+     * This function writes the homes user entries to @p device. It returns
+     * FALSE if there are no entries.
+     */
+    bool writeFile(QIODevice *device);
+
     /**
      * Pointer to the Smb4KHomesSharesHandlerPrivate class
      */
@@ -14,6 +14,7 @@
 #include "smb4khomesshareshandler.h"
 #include "smb4knotification.h"
 #include "smb4kprofilemanager.h"
+#include "smb4kserverprobe.h"
 #include "smb4ksettings.h"
 #include "smb4kshare.h"
 
@@ -24,23 +25,31 @@
 #endif
 
 // system includes
+#include <algorithm>
 #include <fcntl.h>
 #include <unistd.h>
 
 // Qt includes
 #include <QApplication>
+#include <QAtomicInteger>
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
 #include <QApplicationStatic>
 #else
 #include <qapplicationstatic.h>
 #endif
 #include <QDBusUnixFileDescriptor>
+#include <QDeadlineTimer>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QSet>
 #include <QStorageInfo>
-#include <QTcpSocket>
+#include <QThreadPool>
 #include <QTimer>
 #include <QUdpSocket>
 
@@ -55,6 +64,27 @@
 using namespace Smb4KGlobal;
 
 #define TIMEOUT 50
+#define MAX_CONCURRENT_MOUNTS 4
+#define MIN_CHECK_INTERVAL 2500
+#define MAX_CHECK_INTERVAL 60000
+#define CHECK_TIMEOUT 5000
+#define MAX_CONCURRENT_CHECKS 8
+#define RESUME_MIN_BACKOFF 1000
+#define RESUME_MAX_BACKOFF 16000
+#define RESUME_MAX_ATTEMPTS 6
+#define HELPER_TIMEOUT_MARGIN 5000
+
+//
+// The state of a mount point as determined by a check
+//
+struct Smb4KMountPointState {
+    bool accessible = false;
+    qint64 freeDiskSpace = 0;
+    qint64 totalDiskSpace = 0;
+    bool ownerKnown = false;
+    K_UID ownerId = 0;
+    K_GID groupId = 0;
+};
 
 class Smb4KMounterPrivate
 {
@@ -62,16 +92,43 @@ public:
     int remountTimeout;
     int remountAttempts;
     int timerId;
-    int checkTimeout;
     QList<SharePtr> newlyMounted;
     QList<SharePtr> newlyUnmounted;
     QList<SharePtr> retries;
     QList<SharePtr> remounts;
+    QMultiHash<QString, SharePtr> probedRemounts;
+    QList<SharePtr> reachableRemounts;
+    QTimer remountTimer;
+    bool resumeRunning;
+    int resumeAttempts;
+    QTimer resumeBackoffTimer;
+    QElapsedTimer resumeTimer;
+    QElapsedTimer resumePhaseTimer;
+    QStringList resumeTimings;
+    QSet<QString> resumeShares;
+    QList<SharePtr> mountQueue;
+    int runningMountJobs;
+    bool startingMountJobs;
+    bool mountBatchRunning;
     bool detectAllShares;
     bool longActionRunning;
-    QStorageInfo storageInfo;
+    struct MountedShareCheck {
+        SharePtr share;
+        QSharedPointer<QAtomicInteger<qint64>> startTime;
+        bool hung;
+    };
+    struct CheckSchedule {
+        QElapsedTimer lastCheck;
+        int interval;
+        int offset;
+    };
+    QHash<QString, MountedShareCheck> runningChecks;
+    QHash<QString, CheckSchedule> checkSchedules;
+    QList<QPointer<QObject>> visibleViews;
+    double checkBudget;
+    QThreadPool *checkThreadPool;
+    QSharedPointer<QObject> checkReceiver;
     QUdpSocket udpSocket;
-    QTcpSocket tcpSocket;
 };
 
 class Smb4KMounterStatic
@@ -92,16 +149,54 @@ Smb4KMounter::Smb4KMounter(QObject *parent)
     d->timerId = -1;
     d->remountTimeout = 0;
     d->remountAttempts = 0;
-    d->checkTimeout = 0;
+    d->resumeRunning = false;
+    d->resumeAttempts = 0;
+    d->runningMountJobs = 0;
+    d->startingMountJobs = false;
+    d->mountBatchRunning = false;
     d->longActionRunning = false;
     d->detectAllShares = Smb4KMountSettings::detectAllShares();
 
+    //
+    // The mounted shares are checked in worker threads. A check of a share
+    // whose server died might block for a long time.
+    //
+    d->checkThreadPool = new QThreadPool();
+    d->checkThreadPool->setMaxThreadCount(MAX_CONCURRENT_CHECKS);
+    d->checkBudget = 0.0;
+
+    //
+    // The results of the checks are posted to the main thread through this
+    // object. It is shared with the checks, so that it outlives the mounter
+    // while a check hangs.
+    //
+    d->checkReceiver = QSharedPointer<QObject>(new QObject(), &QObject::deleteLater);
+
+    //
+    // Shares whose servers answered the probe at about the same time are
+    // remounted together
+    //
+    d->remountTimer.setSingleShot(true);
+    d->remountTimer.setInterval(TIMEOUT);
+
+    connect(&d->remountTimer, &QTimer::timeout, this, &Smb4KMounter::slotMountReachableRemounts);
+
+    //
+    // After a wake up, the remounts are retried with an exponential backoff
+    //
+    d->resumeBackoffTimer.setSingleShot(true);
+
+    connect(&d->resumeBackoffTimer, &QTimer::timeout, this, &Smb4KMounter::slotResumeBackoffTimeout);
+    connect(Smb4KServerProbe::self(), &Smb4KServerProbe::probeFinished, this, &Smb4KMounter::slotServerProbed);
+
     connect(Smb4KProfileManager::self(), &Smb4KProfileManager::aboutToChangeProfile, this, &Smb4KMounter::slotAboutToChangeProfile);
     connect(Smb4KProfileManager::self(), &Smb4KProfileManager::activeProfileChanged, this, &Smb4KMounter::slotActiveProfileChanged);
     connect(Smb4KCredentialsManager::self(), &Smb4KCredentialsManager::credentialsUpdated, this, &Smb4KMounter::slotCredentialsUpdated);
     connect(Smb4KMountSettings::self(), &Smb4KMountSettings::configChanged, this, &Smb4KMounter::slotConfigChanged);
 
     connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::onlineStateChanged, this, &Smb4KMounter::slotOnlineStateChanged);
+    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkAddressesChanged, this, &Smb4KMounter::slotNetworkAddressesChanged);
+    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::systemSleepStateChanged, this, &Smb4KMounter::slotSystemSleepStateChanged);
     connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkShareAdded, this, &Smb4KMounter::slotShareMounted);
     connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkShareRemoved, this, &Smb4KMounter::slotShareUnmounted);
 
@@ -125,6 +220,27 @@ Smb4KMounter::~Smb4KMounter()
     while (!d->remounts.isEmpty()) {
         d->remounts.takeFirst().clear();
     }
+
+    d->probedRemounts.clear();
+
+    while (!d->reachableRemounts.isEmpty()) {
+        d->reachableRemounts.takeFirst().clear();
+    }
+
+    while (!d->mountQueue.isEmpty()) {
+        d->mountQueue.takeFirst().clear();
+    }
+
+    //
+    // A check that hangs in the kernel cannot be interrupted. Waiting for
+    // it would block the application on exit, so the thread pool is only
+    // deleted if no checks are running.
+    //
+    if (d->runningChecks.isEmpty()) {
+        delete d->checkThreadPool;
+    }
+
+    d->runningChecks.clear();
 }
 
 Smb4KMounter *Smb4KMounter::self()
@@ -138,6 +254,10 @@ void Smb4KMounter::abort()
         return;
     }
 
+    while (!d->mountQueue.isEmpty()) {
+        d->mountQueue.takeFirst().clear();
+    }
+
     QListIterator<KJob *> it(subjobs());
 
     while (it.hasNext()) {
@@ -147,7 +267,12 @@ void Smb4KMounter::abort()
 
 bool Smb4KMounter::isRunning()
 {
-    return (hasSubjobs() || d->longActionRunning);
+    return (hasSubjobs() || d->longActionRunning || d->mountBatchRunning || !d->mountQueue.isEmpty());
+}
+
+QStringList Smb4KMounter::resumeTimings() const
+{
+    return d->resumeTimings;
 }
 
 void Smb4KMounter::triggerRemounts(bool fillList)
@@ -157,65 +282,235 @@ void Smb4KMounter::triggerRemounts(bool fillList)
     }
 
     if (fillList) {
-        QList<CustomSettingsPtr> options = Smb4KCustomSettingsManager::self()->sharesToRemount();
+        const QList<SharePtr> shares = remountCandidates();
 
-        for (const CustomSettingsPtr &option : std::as_const(options)) {
-            if (option->remount() == Smb4KCustomSettings::RemountOnce && !Smb4KMountSettings::remountShares()) {
-                continue;
+        // Read the credentials while the servers are probed
+        prefetchRemountCredentials(shares);
+
+        for (const SharePtr &share : shares) {
+            if (Smb4KMountSettings::checkServerOnlineState()) {
+                // Check if the server is online. All servers are probed in
+                // parallel and a share is remounted as soon as its server
+                // answered.
+                d->probedRemounts.insert(share->hostName().toUpper(), share);
+                Smb4KServerProbe::self()->probe(share->hostName(), share->hostIpAddress());
+            } else {
+                d->remounts << share;
             }
+        }
+    }
 
-            SharePtr share;
-            QDir dir(generateMountPoint(option->url()));
+    mountShares(d->remounts);
+    d->remountAttempts++;
+}
 
-            if (!dir.canonicalPath().isEmpty()) {
-                share = findShareByPath(dir.canonicalPath());
-            }
+QList<SharePtr> Smb4KMounter::remountCandidates()
+{
+    QList<SharePtr> shares;
+    QList<CustomSettingsPtr> options = Smb4KCustomSettingsManager::self()->sharesToRemount();
 
-            if (share) {
-                continue;
-            }
+    for (const CustomSettingsPtr &option : std::as_const(options)) {
+        if (option->remount() == Smb4KCustomSettings::RemountOnce && !Smb4KMountSettings::remountShares()) {
+            continue;
+        }
 
-            bool createAndAddShare = true;
+        SharePtr share;
+        QDir dir(generateMountPoint(option->url()));
 
-            if (Smb4KMountSettings::checkServerOnlineState()) {
-                // Check if the server is online. We try to connect on default
-                // port 445. Prefer the IP address over the host name.
-                QString hostName = !option->ipAddress().isEmpty() ? option->ipAddress() : option->hostName();
-                d->tcpSocket.connectToHost(hostName, 445);
-                createAndAddShare = d->tcpSocket.waitForConnected(3000);
-                d->tcpSocket.abort();
-            }
+        if (!dir.canonicalPath().isEmpty()) {
+            share = findShareByPath(dir.canonicalPath());
+        }
 
-            if (!createAndAddShare) {
-                continue;
-            }
+        if (share) {
+            continue;
+        }
 
-            share = SharePtr::create();
-            share->setUrl(option->url());
-            share->setWorkgroupName(option->workgroupName());
-            share->setHostIpAddress(option->ipAddress());
+        share = SharePtr::create();
+        share->setUrl(option->url());
+        share->setWorkgroupName(option->workgroupName());
+        share->setHostIpAddress(option->ipAddress());
 
-            if (share->url().isValid() && !share->url().isEmpty()) {
-                d->remounts << share;
-            }
+        if (!share->url().isValid() || share->url().isEmpty()) {
+            continue;
         }
+
+        shares << share;
     }
 
-    mountShares(d->remounts);
-    d->remountAttempts++;
+    return shares;
+}
+
+void Smb4KMounter::prefetchRemountCredentials(const QList<SharePtr> &shares)
+{
+    //
+    // All keys the shares need - per share, per host and the default
+    // one - are read in one asynchronous batch. The mount jobs then find
+    // the credentials in the cache or wait for the running lookup.
+    //
+    QList<NetworkItemPtr> networkItems;
+
+    for (const SharePtr &share : shares) {
+        networkItems << share;
+    }
+
+    if (!networkItems.isEmpty()) {
+        Smb4KCredentialsManager::self()->fetchLoginCredentials(networkItems);
+    }
+}
+
+void Smb4KMounter::startResumeAttempt()
+{
+    d->resumeAttempts++;
+    d->resumePhaseTimer.restart();
+
+    //
+    // Start from scratch, so that no share is mounted twice
+    //
+    while (!d->remounts.isEmpty()) {
+        d->remounts.takeFirst().clear();
+    }
+
+    d->probedRemounts.clear();
+    d->remountTimer.stop();
+
+    while (!d->reachableRemounts.isEmpty()) {
+        d->reachableRemounts.takeFirst().clear();
+    }
+
+    const QList<SharePtr> shares = remountCandidates();
+
+    if (shares.isEmpty()) {
+        finishResume();
+        return;
+    }
+
+    //
+    // Remember the shares that are still to be remounted, so that the
+    // mount points do not need to be looked up again each time a share
+    // was mounted
+    //
+    d->resumeShares.clear();
+
+    for (const SharePtr &share : shares) {
+        d->resumeShares << share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toLower();
+    }
+
+    //
+    // The results of the probes before the sleep are outdated. The
+    // credentials are read while the servers are probed.
+    //
+    Smb4KServerProbe::self()->invalidate();
+    prefetchRemountCredentials(shares);
+
+    for (const SharePtr &share : shares) {
+        d->probedRemounts.insert(share->hostName().toUpper(), share);
+    }
+
+    for (const SharePtr &share : shares) {
+        Smb4KServerProbe::self()->probe(share->hostName(), share->hostIpAddress());
+    }
+
+    d->resumeBackoffTimer.start(qMin(RESUME_MIN_BACKOFF << (d->resumeAttempts - 1), RESUME_MAX_BACKOFF));
+}
+
+void Smb4KMounter::finishResume()
+{
+    d->resumeBackoffTimer.stop();
+    d->resumeRunning = false;
+    d->resumeShares.clear();
+
+    d->resumeTimings << QStringLiteral("mount #%1: %2 ms").arg(d->resumeAttempts).arg(d->resumePhaseTimer.elapsed());
+    d->resumeTimings << QStringLiteral("total: %1 ms").arg(d->resumeTimer.elapsed());
+
+    //
+    // The shares that could not be remounted are retried by the regular
+    // remount loop
+    //
+    while (!d->remounts.isEmpty()) {
+        d->remounts.takeFirst().clear();
+    }
+
+    d->probedRemounts.clear();
+    d->remounts = remountCandidates();
+    d->remountAttempts = 1;
+    d->remountTimeout = 0;
 }
 
 void Smb4KMounter::mountShare(const SharePtr &share)
 {
     Q_ASSERT(share);
 
-    if (!share) {
+    if (share && !d->mountQueue.contains(share)) {
+        d->mountQueue << share;
+        startMountJobs();
+    }
+}
+
+void Smb4KMounter::mountShares(const QList<SharePtr> &shares)
+{
+    //
+    // The shares are mounted by one invocation of the mount helper, so that
+    // the authorization is only needed once. The ones that were mounted are
+    // reported by one notification when the whole batch finished.
+    //
+    d->mountBatchRunning = true;
+
+    QList<SharePtr> batch;
+
+    for (const SharePtr &share : shares) {
+        if (share && !d->mountQueue.contains(share) && !batch.contains(share)) {
+            batch << share;
+        }
+    }
+
+    //
+    // Preparing the shares might spin the event loop (Wake-On-LAN), so
+    // finished jobs must not close the batch meanwhile.
+    //
+    bool startingMountJobs = d->startingMountJobs;
+    d->startingMountJobs = true;
+
+    startMountBatchJob(batch);
+
+    d->startingMountJobs = startingMountJobs;
+
+    startMountJobs();
+}
+
+void Smb4KMounter::startMountJobs()
+{
+    //
+    // Starting a mount job might spin the event loop (Wake-On-LAN), so
+    // finished jobs could call this function again.
+    //
+    if (d->startingMountJobs) {
         return;
     }
 
+    d->startingMountJobs = true;
+
+    while (!d->mountQueue.isEmpty() && d->runningMountJobs < MAX_CONCURRENT_MOUNTS) {
+        startMountJob(d->mountQueue.takeFirst());
+    }
+
+    d->startingMountJobs = false;
+
+    if (d->mountBatchRunning && d->mountQueue.isEmpty() && d->runningMountJobs == 0) {
+        finishMountBatch();
+    }
+}
+
+bool Smb4KMounter::prepareMount(const SharePtr &share, int *fd, QVariantMap &mountArguments)
+{
+    Q_ASSERT(share);
+
+    if (!share) {
+        return false;
+    }
+
     if (!share->url().isValid() || share->url().host().isEmpty() || share->url().path().isEmpty() || share->url().path().length() == 1) {
         Smb4KNotification::invalidURLPassed();
-        return;
+        return false;
     }
 
     // Check if the share has already been mounted. If it is, return. Since
@@ -225,7 +520,7 @@ void Smb4KMounter::mountShare(const SharePtr &share)
     QDir dir(generateMountPoint(shareUrl));
 
     if (!dir.canonicalPath().isEmpty() && findShareByPath(dir.canonicalPath())) {
-        return;
+        return false;
     }
 
     // Wake-On-LAN: Wake the host up before mounting any shares
@@ -258,51 +553,156 @@ void Smb4KMounter::mountShare(const SharePtr &share)
 
     Smb4KCredentialsManager::self()->readLoginCredentials(share);
 
+    if (!fillMountActionArgs(share, fd, mountArguments)) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool Smb4KMounter::startMountJob(const SharePtr &share)
+{
     QVariantMap mountArguments;
     int fileDescriptor = -1;
 
-    if (!fillMountActionArgs(share, &fileDescriptor, mountArguments)) {
-        if (fileDescriptor >= 0) {
-            close(fileDescriptor);
-        }
-        return;
+    if (!prepareMount(share, &fileDescriptor, mountArguments)) {
+        return false;
     }
 
+    mountArguments.insert(QStringLiteral("mh_timeout"), 1000 * Smb4KMountSettings::mountTimeout());
+
     KAuth::Action mountAction(QStringLiteral("org.kde.smb4k.mounthelper.mount"));
     mountAction.setHelperId(QStringLiteral("org.kde.smb4k.mounthelper"));
     mountAction.setArguments(mountArguments);
+    mountAction.setTimeout(1000 * Smb4KMountSettings::mountTimeout() + HELPER_TIMEOUT_MARGIN);
 
     KAuth::ExecuteJob *job = mountAction.execute();
     addSubjob(job);
 
+    //
+    // Connect after the job was added, so that it was already removed
+    // from the subjobs when its result is processed
+    //
+    connect(job, &KJob::result, this, [this, share, fileDescriptor](KJob *finishedJob) {
+        finishMountJob(finishedJob, share, fileDescriptor);
+    });
+
+    d->runningMountJobs++;
+
     Q_EMIT aboutToStart(MountShare);
 
-    if (job->exec()) {
-        QString errorMsg = job->data().value(QStringLiteral("mh_error_message")).toString();
+    job->start();
 
-        if (!errorMsg.isEmpty()) {
-#if defined(Q_OS_LINUX)
-            if (errorMsg.contains(QStringLiteral("mount error 13")) || errorMsg.contains(QStringLiteral("mount error(13)")) /* authentication error */) {
-                d->retries << share;
-                Q_EMIT requestCredentials(share);
-            } else if (errorMsg.contains(QStringLiteral("Unable to find suitable address."))) {
-                // Swallow this
+    return true;
+}
+
+bool Smb4KMounter::startMountBatchJob(const QList<SharePtr> &shares)
+{
+    QList<SharePtr> batchShares;
+    QVariantList batchArguments;
+    int ticketDescriptor = -1;
+
+    for (const SharePtr &share : shares) {
+        QVariantMap mountArguments;
+        int fileDescriptor = -1;
+
+        if (!prepareMount(share, &fileDescriptor, mountArguments)) {
+            continue;
+        }
+
+        // The Kerberos ticket is the same for all shares, so it is
+        // passed to the helper only once.
+        mountArguments.remove(QStringLiteral("mh_krb5ticket"));
+
+        if (fileDescriptor >= 0) {
+            if (ticketDescriptor == -1) {
+                ticketDescriptor = fileDescriptor;
             } else {
-                Smb4KNotification::mountingFailed(share, errorMsg);
+                close(fileDescriptor);
             }
-#elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
-            if (errorMsg.contains(QStringLiteral("Authentication error")) || errorMsg.contains(QStringLiteral("Permission denied"))) {
-                d->retries << share;
-                Q_EMIT requestCredentials(share);
+        }
+
+        batchShares << share;
+        batchArguments << mountArguments;
+    }
+
+    if (batchShares.isEmpty()) {
+        if (ticketDescriptor >= 0) {
+            close(ticketDescriptor);
+        }
+        return false;
+    }
+
+    QVariantMap mountArguments;
+    mountArguments.insert(QStringLiteral("mh_shares"), batchArguments);
+    mountArguments.insert(QStringLiteral("mh_timeout"), 1000 * Smb4KMountSettings::mountTimeout());
+
+    if (ticketDescriptor >= 0) {
+        mountArguments.insert(QStringLiteral("mh_krb5ticket"), QVariant::fromValue(QDBusUnixFileDescriptor(ticketDescriptor)));
+    }
+
+    KAuth::Action mountAction(QStringLiteral("org.kde.smb4k.mounthelper.mountbatch"));
+    mountAction.setHelperId(QStringLiteral("org.kde.smb4k.mounthelper"));
+    mountAction.setArguments(mountArguments);
+    mountAction.setTimeout(1000 * Smb4KMountSettings::mountTimeout() + HELPER_TIMEOUT_MARGIN);
+
+    KAuth::ExecuteJob *job = mountAction.execute();
+    addSubjob(job);
+
+    connect(job, &KJob::result, this, [this, batchShares, ticketDescriptor](KJob *finishedJob) {
+        finishMountBatchJob(finishedJob, batchShares, ticketDescriptor);
+    });
+
+    d->runningMountJobs++;
+
+    Q_EMIT aboutToStart(MountShare);
+
+    job->start();
+
+    return true;
+}
+
+void Smb4KMounter::finishMountJob(KJob *job, const SharePtr &share, int fileDescriptor)
+{
+    if (!job->error()) {
+        processMountError(share, static_cast<KAuth::ExecuteJob *>(job)->data().value(QStringLiteral("mh_error_message")).toString());
+    } else if (job->error() != KJob::KilledJobError) {
+        Smb4KNotification::actionFailed(job->error(), job->errorString());
+    }
+
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+
+    d->runningMountJobs--;
+
+    Q_EMIT finished(MountShare);
+
+    // Continue with the queued shares
+    startMountJobs();
+}
+
+void Smb4KMounter::finishMountBatchJob(KJob *job, const QList<SharePtr> &shares, int fileDescriptor)
+{
+    if (!job->error()) {
+        // The results are in the same order as the shares were passed.
+        // If the action was stopped, results might be missing.
+        const QVariantList results = static_cast<KAuth::ExecuteJob *>(job)->data().value(QStringLiteral("mh_results")).toList();
+
+        for (int i = 0; i < results.size() && i < shares.size(); ++i) {
+            QVariantMap result = results.at(i).toMap();
+
+            if (result.contains(QStringLiteral("mh_error_description"))) {
+                Smb4KNotification::mountingFailed(shares.at(i), result.value(QStringLiteral("mh_error_description")).toString());
             } else {
-                Smb4KNotification::mountingFailed(share, errorMsg);
+                processMountError(shares.at(i), result.value(QStringLiteral("mh_error_message")).toString());
             }
-#else
-            qWarning() << "Smb4KMounter::slotMountJobFinished(): Error handling not implemented!";
-            Smb4KNotification::mountingFailed(share, errorMsg);
-#endif
         }
-    } else {
+    } else if (job->error() != KJob::KilledJobError) {
         Smb4KNotification::actionFailed(job->error(), job->errorString());
     }
 
@@ -310,20 +710,45 @@ void Smb4KMounter::mountShare(const SharePtr &share)
         close(fileDescriptor);
     }
 
-    removeSubjob(job);
+    d->runningMountJobs--;
 
     Q_EMIT finished(MountShare);
+
+    // Continue with the queued shares
+    startMountJobs();
 }
 
-void Smb4KMounter::mountShares(const QList<SharePtr> &shares)
+void Smb4KMounter::processMountError(const SharePtr &share, const QString &errorMsg)
 {
-    d->longActionRunning = true;
+    if (errorMsg.isEmpty()) {
+        return;
+    }
 
-    for (const SharePtr &share : shares) {
-        mountShare(share);
+#if defined(Q_OS_LINUX)
+    if (errorMsg.contains(QStringLiteral("mount error 13")) || errorMsg.contains(QStringLiteral("mount error(13)")) /* authentication error */) {
+        d->retries << share;
+        Q_EMIT requestCredentials(share);
+    } else if (errorMsg.contains(QStringLiteral("Unable to find suitable address."))) {
+        // Swallow this
+    } else {
+        Smb4KNotification::mountingFailed(share, errorMsg);
     }
+#elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
+    if (errorMsg.contains(QStringLiteral("Authentication error")) || errorMsg.contains(QStringLiteral("Permission denied"))) {
+        d->retries << share;
+        Q_EMIT requestCredentials(share);
+    } else {
+        Smb4KNotification::mountingFailed(share, errorMsg);
+    }
+#else
+    qWarning() << "Smb4KMounter::processMountError(): Error handling not implemented!";
+    Smb4KNotification::mountingFailed(share, errorMsg);
+#endif
+}
 
-    d->longActionRunning = false;
+void Smb4KMounter::finishMountBatch()
+{
+    d->mountBatchRunning = false;
 
     if (Smb4KHardwareInterface::self()->initialImportDone()) {
         if (d->newlyMounted.size() > 1) {
@@ -377,9 +802,12 @@ void Smb4KMounter::unmountShare(const SharePtr &share, bool silent)
         return;
     }
 
+    unmountArguments.insert(QStringLiteral("mh_timeout"), 1000 * Smb4KMountSettings::mountTimeout());
+
     KAuth::Action unmountAction(QStringLiteral("org.kde.smb4k.mounthelper.unmount"));
     unmountAction.setHelperId(QStringLiteral("org.kde.smb4k.mounthelper"));
     unmountAction.setArguments(unmountArguments);
+    unmountAction.setTimeout(1000 * Smb4KMountSettings::mountTimeout() + HELPER_TIMEOUT_MARGIN);
 
     KAuth::ExecuteJob *job = unmountAction.execute();
     addSubjob(job);
@@ -462,8 +890,9 @@ void Smb4KMounter::timerEvent(QTimerEvent *event)
     Q_UNUSED(event);
 
     if (!isRunning() && Smb4KHardwareInterface::self()->isOnline()) {
-        // Try to remount shares
-        if (d->remountAttempts < Smb4KMountSettings::remountAttempts() && Smb4KHardwareInterface::self()->initialImportDone()) {
+        // Try to remount shares. After a wake up, this is done by the
+        // resume pipeline.
+        if (!d->resumeRunning && d->remountAttempts < Smb4KMountSettings::remountAttempts() && Smb4KHardwareInterface::self()->initialImportDone()) {
             if (d->remountAttempts == 0) {
                 triggerRemounts(true);
             }
@@ -477,17 +906,10 @@ void Smb4KMounter::timerEvent(QTimerEvent *event)
         }
 
         // Check the size, accessibility, etc. of the shares
-        if (d->checkTimeout >= 2500) {
-            for (const SharePtr &share : mountedSharesList()) {
-                checkMountedShare(share);
-                Q_EMIT updated(share);
-            }
-
-            d->checkTimeout = 0;
-        } else {
-            d->checkTimeout += TIMEOUT;
-        }
+        scheduleMountedShareChecks();
     }
+
+    checkHungShares();
 }
 
 #if defined(Q_OS_LINUX)
@@ -1133,35 +1555,303 @@ bool Smb4KMounter::fillUnmountActionArgs(const SharePtr &, bool, bool, QVariantM
 }
 #endif
 
-void Smb4KMounter::checkMountedShare(const SharePtr &share) const
+static Smb4KMountPointState readMountPointState(const QString &path)
 {
-    d->storageInfo.setPath(share->path());
-
-    if (d->storageInfo.isValid() && d->storageInfo.isReady()) {
-        // Accessibility
-        share->setInaccessible(false);
+    //
+    // This function might be run in a worker thread and block for a long
+    // time, so it must not touch any share object.
+    //
+    Smb4KMountPointState state;
+    QStorageInfo storageInfo(path);
 
-        // Size information
-        share->setFreeDiskSpace(d->storageInfo.bytesAvailable()); // Bytes available to the user, might be less than bytesFree()
-        share->setTotalDiskSpace(d->storageInfo.bytesTotal());
+    if (storageInfo.isValid() && storageInfo.isReady()) {
+        state.accessible = true;
+        state.freeDiskSpace = storageInfo.bytesAvailable(); // Bytes available to the user, might be less than bytesFree()
+        state.totalDiskSpace = storageInfo.bytesTotal();
 
         // Get the owner an group, if possible.
-        QFileInfo fileInfo(share->path());
+        QFileInfo fileInfo(path);
         fileInfo.setCaching(false);
 
         if (fileInfo.exists()) {
-            share->setUser(KUser(static_cast<K_UID>(fileInfo.ownerId())));
-            share->setGroup(KUserGroup(static_cast<K_GID>(fileInfo.groupId())));
-        } else {
-            share->setUser(KUser(KUser::UseRealUserID));
-            share->setGroup(KUserGroup(KUser::UseRealUserID));
+            state.ownerKnown = true;
+            state.ownerId = static_cast<K_UID>(fileInfo.ownerId());
+            state.groupId = static_cast<K_GID>(fileInfo.groupId());
+        }
+    }
+
+    return state;
+}
+
+static bool applyMountPointState(const SharePtr &share, const Smb4KMountPointState &state)
+{
+    bool changed = false;
+
+    // Accessibility
+    if (share->isInaccessible() == state.accessible) {
+        share->setInaccessible(!state.accessible);
+        changed = true;
+    }
+
+    // Size information
+    if (share->freeDiskSpace() != state.freeDiskSpace) {
+        share->setFreeDiskSpace(state.freeDiskSpace);
+        changed = true;
+    }
+
+    if (share->totalDiskSpace() != state.totalDiskSpace) {
+        share->setTotalDiskSpace(state.totalDiskSpace);
+        changed = true;
+    }
+
+    // Owner and group. Fall back to the user if they are not known.
+    KUser user = state.ownerKnown ? KUser(state.ownerId) : KUser(KUser::UseRealUserID);
+    KUserGroup group = state.ownerKnown ? KUserGroup(state.groupId) : KUserGroup(KUser::UseRealUserID);
+
+    if (share->user().userId() != user.userId()) {
+        share->setUser(user);
+        changed = true;
+    }
+
+    if (share->group().groupId() != group.groupId()) {
+        share->setGroup(group);
+        changed = true;
+    }
+
+    return changed;
+}
+
+static Smb4KMounterPrivate::CheckSchedule createCheckSchedule()
+{
+    //
+    // Spread the checks of the shares over time
+    //
+    Smb4KMounterPrivate::CheckSchedule schedule;
+    schedule.lastCheck.start();
+    schedule.interval = MIN_CHECK_INTERVAL;
+    schedule.offset = QRandomGenerator::global()->bounded(MIN_CHECK_INTERVAL);
+
+    return schedule;
+}
+
+bool Smb4KMounter::canStartMountedShareCheck(const SharePtr &share) const
+{
+    //
+    // Do not queue checks in the thread pool. A queued check is not
+    // running yet and must never be regarded as hung.
+    //
+    if (d->runningChecks.size() >= MAX_CONCURRENT_CHECKS) {
+        return false;
+    }
+
+    //
+    // Only check one share of a server at a time. If the server died, its
+    // checks would otherwise block all worker threads.
+    //
+    for (const Smb4KMounterPrivate::MountedShareCheck &check : std::as_const(d->runningChecks)) {
+        if (QString::compare(check.share->url().host(), share->url().host(), Qt::CaseInsensitive) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Smb4KMounter::checkMountedShare(const SharePtr &share)
+{
+    if (d->runningChecks.contains(share->path())) {
+        return;
+    }
+
+    if (canStartMountedShareCheck(share)) {
+        startMountedShareCheck(share);
+    } else {
+        // Make the share due, so that it is checked as soon as possible
+        Smb4KMounterPrivate::CheckSchedule schedule = createCheckSchedule();
+        schedule.interval = 0;
+        schedule.offset = 0;
+        d->checkSchedules.insert(share->path(), schedule);
+    }
+}
+
+void Smb4KMounter::setSharesViewVisible(QObject *view, bool visible)
+{
+    d->visibleViews.removeAll(nullptr);
+
+    if (visible) {
+        if (!d->visibleViews.contains(view)) {
+            d->visibleViews << view;
         }
     } else {
-        share->setInaccessible(true);
-        share->setFreeDiskSpace(0);
-        share->setTotalDiskSpace(0);
-        share->setUser(KUser(KUser::UseRealUserID));
-        share->setGroup(KUserGroup(KUser::UseRealUserID));
+        d->visibleViews.removeAll(view);
+    }
+}
+
+void Smb4KMounter::scheduleMountedShareChecks()
+{
+    //
+    // Refill the budget. It is capped, so that the checks are spread over
+    // time instead of being done in bursts.
+    //
+    double checksPerTick = Smb4KMountSettings::checkBudget() * TIMEOUT / 1000.0;
+    d->checkBudget = qMin(qMax(1.0, checksPerTick), d->checkBudget + checksPerTick);
+
+    d->visibleViews.removeAll(nullptr);
+    bool viewVisible = !d->visibleViews.isEmpty();
+
+    //
+    // Collect the shares that are due. While the shares are shown to the
+    // user, they are checked at the shortest interval.
+    //
+    QList<std::pair<qint64, SharePtr>> dueShares;
+    const QList<SharePtr> shares = mountedSharesList();
+
+    for (const SharePtr &share : shares) {
+        auto it = d->checkSchedules.find(share->path());
+
+        if (it == d->checkSchedules.end()) {
+            it = d->checkSchedules.insert(share->path(), createCheckSchedule());
+        }
+
+        int interval = (viewVisible ? MIN_CHECK_INTERVAL : it->interval) + it->offset;
+        qint64 overdue = it->lastCheck.elapsed() - interval;
+
+        if (overdue >= 0 && !d->runningChecks.contains(share->path())) {
+            dueShares << std::make_pair(overdue, share);
+        }
+    }
+
+    // Check the most overdue shares first
+    std::sort(dueShares.begin(), dueShares.end(), [](const std::pair<qint64, SharePtr> &a, const std::pair<qint64, SharePtr> &b) {
+        return a.first > b.first;
+    });
+
+    for (const std::pair<qint64, SharePtr> &dueShare : std::as_const(dueShares)) {
+        if (d->checkBudget < 1.0 || d->runningChecks.size() >= MAX_CONCURRENT_CHECKS) {
+            break;
+        }
+
+        if (!canStartMountedShareCheck(dueShare.second)) {
+            continue;
+        }
+
+        startMountedShareCheck(dueShare.second);
+        d->checkBudget -= 1.0;
+    }
+}
+
+void Smb4KMounter::resetCheckSchedules()
+{
+    for (auto it = d->checkSchedules.begin(); it != d->checkSchedules.end(); ++it) {
+        it->interval = MIN_CHECK_INTERVAL;
+    }
+}
+
+void Smb4KMounter::startMountedShareCheck(const SharePtr &share)
+{
+    QString path = share->path();
+
+    Smb4KMounterPrivate::MountedShareCheck check;
+    check.share = share;
+    check.startTime = QSharedPointer<QAtomicInteger<qint64>>::create(0);
+    check.hung = false;
+
+    d->runningChecks.insert(path, check);
+
+    auto schedule = d->checkSchedules.find(path);
+
+    if (schedule == d->checkSchedules.end()) {
+        schedule = d->checkSchedules.insert(path, createCheckSchedule());
+    }
+
+    schedule->lastCheck.start();
+
+    //
+    // The worker thread only posts the result to the receiver, which lives
+    // in the main thread. The mounter is not accessed before the result
+    // arrived there.
+    //
+    QPointer<Smb4KMounter> mounter(this);
+    QSharedPointer<QObject> receiver = d->checkReceiver;
+    QSharedPointer<QAtomicInteger<qint64>> startTime = check.startTime;
+
+    d->checkThreadPool->start([mounter = std::move(mounter), receiver, path, startTime]() mutable {
+        //
+        // The deadline starts when the check begins and not when it was
+        // queued
+        //
+        startTime->storeRelease(QDeadlineTimer::current().deadline());
+
+        Smb4KMountPointState state = readMountPointState(path);
+
+        //
+        // Return to the main thread
+        //
+        QMetaObject::invokeMethod(
+            receiver.data(),
+            [mounter = std::move(mounter), path, state]() {
+                if (mounter) {
+                    mounter->finishMountedShareCheck(path, state);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void Smb4KMounter::finishMountedShareCheck(const QString &path, const Smb4KMountPointState &state)
+{
+    Smb4KMounterPrivate::MountedShareCheck check = d->runningChecks.take(path);
+
+    // Ignore shares that were unmounted in the meantime
+    if (!check.share || findShareByPath(path) != check.share) {
+        return;
+    }
+
+    auto schedule = d->checkSchedules.find(path);
+
+    //
+    // Back off for shares that did not change. Shares that changed are
+    // checked at the shortest interval again.
+    //
+    bool inaccessible = check.share->isInaccessible();
+
+    if (applyMountPointState(check.share, state)) {
+        // The canonical path depends on the accessibility
+        if (check.share->isInaccessible() != inaccessible) {
+            updateMountedShare(check.share);
+        }
+
+        if (schedule != d->checkSchedules.end()) {
+            schedule->interval = MIN_CHECK_INTERVAL;
+        }
+
+        Q_EMIT updated(check.share);
+    } else if (schedule != d->checkSchedules.end()) {
+        schedule->interval = qMin(2 * schedule->interval, MAX_CHECK_INTERVAL);
+    }
+}
+
+void Smb4KMounter::checkHungShares()
+{
+    qint64 now = QDeadlineTimer::current().deadline();
+
+    for (auto it = d->runningChecks.begin(); it != d->runningChecks.end(); ++it) {
+        qint64 startTime = it->startTime->loadAcquire();
+
+        // Checks that did not start yet cannot be hung
+        if (it->hung || startTime == 0 || now - startTime < CHECK_TIMEOUT) {
+            continue;
+        }
+
+        //
+        // The check did not return in time, so the server most likely died.
+        // The share is checked again after the blocked check returned.
+        //
+        it->hung = true;
+
+        if (findShareByPath(it.key()) == it->share && applyMountPointState(it->share, Smb4KMountPointState())) {
+            Q_EMIT updated(it->share);
+        }
     }
 }
 
@@ -1179,15 +1869,27 @@ const QString Smb4KMounter::generateMountPoint(const QUrl &url) const
 
 SharePtr Smb4KMounter::createMountedShare(const QString &mountPoint) const
 {
-    KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::BasicInfoNeeded | KMountPoint::NeedMountOptions);
-    KMountPoint::Ptr mp = mountPoints.findByPath(mountPoint);
+    //
+    // Look the mount point up in the snapshot of the mount table. Only if
+    // it is not available, the whole mount table is read.
+    //
+    Smb4KMountPointInfo info;
+
+    if (!Smb4KHardwareInterface::self()->mountPointInfo(mountPoint, &info)) {
+        KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::BasicInfoNeeded | KMountPoint::NeedMountOptions);
+        KMountPoint::Ptr mp = mountPoints.findByPath(mountPoint);
+
+        info.mountPoint = mp->mountPoint();
+        info.mountedFrom = mp->mountedFrom();
+        info.mountOptions = mp->mountOptions();
+    }
 
     SharePtr share = SharePtr::create();
-    share->setUrl(QUrl(mp->mountedFrom()));
-    share->setPath(mp->mountPoint());
+    share->setUrl(QUrl(info.mountedFrom));
+    share->setPath(info.mountPoint);
     share->setMounted(true);
 
-    QStringList mountOptions = mp->mountOptions();
+    const QStringList mountOptions = info.mountOptions;
 
     for (const QString &option : std::as_const(mountOptions)) {
         if (option.startsWith(QStringLiteral("domain=")) || option.startsWith(QStringLiteral("workgroup="))) {
@@ -1206,7 +1908,15 @@ SharePtr Smb4KMounter::createMountedShare(const QString &mountPoint) const
 
     QDir dir(p->userMountPrefix);
 
-    if (!dir.canonicalPath().isEmpty() && share->canonicalPath().startsWith(dir.canonicalPath())) {
+    //
+    // The share has not been checked yet, so it is regarded as inaccessible
+    // until then. The path taken from the mount table is canonical already
+    // and the mount point is not accessed here, because its server might
+    // not respond.
+    //
+    share->setInaccessible(true);
+
+    if (!dir.canonicalPath().isEmpty() && share->path().startsWith(dir.canonicalPath())) {
         share->setForeign(false);
     } else {
         share->setForeign(true);
@@ -1243,7 +1953,20 @@ void Smb4KMounter::slotOnlineStateChanged(bool online)
 {
     if (online) {
         slotStartJobs();
+
+        //
+        // The network came up after a wake up. Start remounting the shares
+        // right away.
+        //
+        if (d->resumeRunning && !d->resumeBackoffTimer.isActive()) {
+            if (d->resumeAttempts == 0) {
+                d->resumeTimings << QStringLiteral("network: %1 ms").arg(d->resumePhaseTimer.elapsed());
+            }
+
+            startResumeAttempt();
+        }
     } else {
+        d->resumeBackoffTimer.stop();
         abort();
         saveSharesForRemount();
 
@@ -1259,6 +1982,20 @@ void Smb4KMounter::slotOnlineStateChanged(bool online)
     }
 }
 
+void Smb4KMounter::slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed)
+{
+    Q_UNUSED(removed);
+
+    //
+    // The shares that could not be remounted might be reachable through
+    // the new addresses. Retry them with the next tick of the timer instead
+    // of waiting for the remount interval to pass.
+    //
+    if (!added.isEmpty() && !d->remounts.isEmpty()) {
+        d->remountTimeout = 60000 * Smb4KMountSettings::remountInterval() + 1;
+    }
+}
+
 void Smb4KMounter::slotAboutToChangeProfile()
 {
     if (Smb4KMountSettings::remountShares()) {
@@ -1280,6 +2017,18 @@ void Smb4KMounter::slotActiveProfileChanged(const QString &newProfile)
         d->remounts.takeFirst().clear();
     }
 
+    d->probedRemounts.clear();
+    d->remountTimer.stop();
+
+    while (!d->reachableRemounts.isEmpty()) {
+        d->reachableRemounts.takeFirst().clear();
+    }
+
+    // Stop the resume pipeline.
+    d->resumeBackoffTimer.stop();
+    d->resumeRunning = false;
+    d->resumeShares.clear();
+
     // Clear all retries.
     while (!d->retries.isEmpty()) {
         d->retries.takeFirst().clear();
@@ -1320,10 +2069,10 @@ void Smb4KMounter::slotConfigChanged()
         for (const QString &mountPoint : std::as_const(mountPoints)) {
             if (!findShareByPath(mountPoint)) {
                 SharePtr share = createMountedShare(mountPoint);
-                checkMountedShare(share);
 
                 if (!share->isForeign() || Smb4KMountSettings::detectAllShares()) {
                     if (addMountedShare(share)) {
+                        checkMountedShare(share);
                         Q_EMIT mounted(share);
                     }
                 }
@@ -1358,15 +2107,96 @@ void Smb4KMounter::slotCredentialsUpdated(const QUrl &url)
     }
 }
 
+void Smb4KMounter::slotServerProbed(const QString &hostName, bool reachable)
+{
+    const QList<SharePtr> shares = d->probedRemounts.values(hostName);
+    d->probedRemounts.remove(hostName);
+
+    if (d->resumeRunning && !shares.isEmpty() && d->probedRemounts.isEmpty()) {
+        d->resumeTimings << QStringLiteral("probe #%1: %2 ms").arg(d->resumeAttempts).arg(d->resumePhaseTimer.elapsed());
+    }
+
+    if (!reachable || shares.isEmpty()) {
+        return;
+    }
+
+    for (const SharePtr &share : shares) {
+        d->remounts << share;
+        d->reachableRemounts << share;
+    }
+
+    if (!d->remountTimer.isActive()) {
+        d->remountTimer.start();
+    }
+}
+
+void Smb4KMounter::slotMountReachableRemounts()
+{
+    QList<SharePtr> shares = d->reachableRemounts;
+
+    while (!d->reachableRemounts.isEmpty()) {
+        d->reachableRemounts.takeFirst().clear();
+    }
+
+    mountShares(shares);
+}
+
+void Smb4KMounter::slotSystemSleepStateChanged(bool sleep)
+{
+    d->resumeBackoffTimer.stop();
+    d->resumeRunning = !sleep;
+    d->resumeAttempts = 0;
+    d->resumeTimings.clear();
+    d->resumeShares.clear();
+
+    if (!sleep) {
+        d->resumeTimer.start();
+        d->resumePhaseTimer.start();
+
+        //
+        // The network might already be up
+        //
+        if (Smb4KHardwareInterface::self()->isOnline()) {
+            d->resumeTimings << QStringLiteral("network: 0 ms");
+            startResumeAttempt();
+        }
+    }
+}
+
+void Smb4KMounter::slotResumeBackoffTimeout()
+{
+    if (!Smb4KHardwareInterface::self()->isOnline()) {
+        return;
+    }
+
+    if (d->resumeAttempts >= RESUME_MAX_ATTEMPTS) {
+        finishResume();
+        return;
+    }
+
+    //
+    // Do not interfere with the running mounts
+    //
+    if (isRunning()) {
+        d->resumeBackoffTimer.start(RESUME_MIN_BACKOFF);
+        return;
+    }
+
+    d->resumeTimings << QStringLiteral("mount #%1: %2 ms").arg(d->resumeAttempts).arg(d->resumePhaseTimer.elapsed());
+
+    startResumeAttempt();
+}
+
 void Smb4KMounter::slotShareMounted(const QString &mountPoint)
 {
     Q_ASSERT(!mountPoint.isEmpty());
 
     SharePtr share = createMountedShare(mountPoint);
-    checkMountedShare(share);
 
     if (!share->isForeign() || Smb4KMountSettings::detectAllShares()) {
         if (addMountedShare(share)) {
+            checkMountedShare(share);
+
             // Remove share from the remounts
             QMutableListIterator<SharePtr> s(d->remounts);
 
@@ -1384,11 +2214,23 @@ void Smb4KMounter::slotShareMounted(const QString &mountPoint)
                 }
             }
 
+            // Poll faster for a while after something was mounted
+            resetCheckSchedules();
+
+            // All shares were remounted after a wake up
+            if (d->resumeRunning && !share->isForeign() && !d->resumeShares.isEmpty()) {
+                d->resumeShares.remove(share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toLower());
+
+                if (d->resumeShares.isEmpty()) {
+                    finishResume();
+                }
+            }
+
             Q_EMIT mounted(share);
 
-            if (d->longActionRunning) {
+            if (d->mountBatchRunning) {
                 d->newlyMounted << share;
-                // Notification is handled in Smb4KMounter::mountShares()
+                // Notification is handled in Smb4KMounter::finishMountBatch()
             } else {
                 if (Smb4KHardwareInterface::self()->initialImportDone()) {
                     Smb4KNotification::shareMounted(share);
@@ -1411,6 +2253,10 @@ void Smb4KMounter::slotShareUnmounted(const QString &mountPoint)
     SharePtr share = findShareByPath(mountPoint);
     share->setMounted(false);
 
+    // Poll faster for a while after something was unmounted
+    d->checkSchedules.remove(mountPoint);
+    resetCheckSchedules();
+
     if (removeMountedShare(share, d->longActionRunning)) {
         Q_EMIT unmounted(share);
     }
@@ -23,11 +23,13 @@
 #include <KCompositeJob>
 
 // forward declarations
+class QNetworkAddressEntry;
 class Smb4KShare;
 class Smb4KAuthInfo;
 class Smb4KMountJob;
 class Smb4KUnmountJob;
 class Smb4KMounterPrivate;
+struct Smb4KMountPointState;
 
 /**
  * This is one of the core classes of Smb4K. It manages the mounting
@@ -117,11 +119,31 @@ public:
      */
     bool isRunning();
 
+    /**
+     * This function returns the durations of the phases of the last
+     * remount after a wake up, e.g. for diagnostics. The list is cleared
+     * when the system goes to sleep or wakes up again.
+     *
+     * @returns the timings of the last remount after a wake up.
+     */
+    QStringList resumeTimings() const;
+
     /**
      * This function starts the composite job
      */
     void start() override;
 
+    /**
+     * Tell the mounter whether the view @p view that shows the mounted
+     * shares to the user is visible. While any view is visible, the
+     * mounted shares are checked at the shortest interval.
+     *
+     * @param view        The view, e.g. a widget or a tool tip
+     *
+     * @param visible     TRUE if the view is visible
+     */
+    void setSharesViewVisible(QObject *view, bool visible);
+
 Q_SIGNALS:
     /**
      * This signal is emitted whenever a share item was updated.
@@ -204,6 +226,16 @@ protected Q_SLOTS:
      */
     void slotOnlineStateChanged(bool online);
 
+    /**
+     * This slot is called when IP addresses were assigned to or removed
+     * from the network interfaces. Pending remounts are retried when
+     * addresses were added.
+     *
+     * @param added           The new addresses
+     * @param removed         The removed addresses
+     */
+    void slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed);
+
     /**
      * This slot is invoked when the active profile is about to be changed
      */
@@ -228,6 +260,36 @@ protected Q_SLOTS:
      */
     void slotCredentialsUpdated(const QUrl &url);
 
+    /**
+     * This slot is called when the reachability of a server was probed.
+     * The shares of a reachable server that are to be remounted are
+     * queued for mounting.
+     *
+     * @param hostName      The host name in upper case
+     *
+     * @param reachable     TRUE if the server is reachable
+     */
+    void slotServerProbed(const QString &hostName, bool reachable);
+
+    /**
+     * This slot mounts the queued shares of the reachable servers.
+     */
+    void slotMountReachableRemounts();
+
+    /**
+     * This slot is called when the system is about to enter a sleep state
+     * or was woken up. After a wake up, the resume pipeline is started.
+     *
+     * @param sleep         TRUE if the system is about to sleep
+     */
+    void slotSystemSleepStateChanged(bool sleep);
+
+    /**
+     * This slot is called when the backoff interval of the resume pipeline
+     * passed. It starts the next attempt to remount the shares.
+     */
+    void slotResumeBackoffTimeout();
+
     /**
      * This slot is called when a share was mounted. It takes the
      * @p mountPoint as an argument.
@@ -255,11 +317,114 @@ private:
      */
     void triggerRemounts(bool fillList);
 
+    /**
+     * Returns the shares that are scheduled for a remount and are not
+     * mounted.
+     *
+     * @returns the list of shares that are to be remounted
+     */
+    QList<SharePtr> remountCandidates();
+
+    /**
+     * Read the login credentials of the shares that are to be remounted
+     * asynchronously in one batch.
+     *
+     * @param shares          The shares that are to be remounted
+     */
+    void prefetchRemountCredentials(const QList<SharePtr> &shares);
+
+    /**
+     * Start an attempt of the resume pipeline. The servers of all shares
+     * that are to be remounted are probed in parallel and the shares of a
+     * server are mounted as soon as it answered.
+     */
+    void startResumeAttempt();
+
+    /**
+     * Finish the resume pipeline, report the timings of its phases and
+     * hand the remaining shares over to the regular remount loop.
+     */
+    void finishResume();
+
     /**
      * Save all shares that need to be remounted.
      */
     void saveSharesForRemount();
 
+    /**
+     * Start mount jobs for the queued shares as long as the maximum
+     * number of concurrent mount jobs is not reached.
+     */
+    void startMountJobs();
+
+    /**
+     * Check the share @p share, wake its host up if necessary and fill the
+     * arguments for the mount action. Returns FALSE if the share must not
+     * be mounted, e.g. because it is already mounted.
+     *
+     * @param share           The share
+     *
+     * @param fd              The file descriptor of the Kerberos ticket or -1
+     *
+     * @param mountArguments  The arguments for the mount action
+     */
+    bool prepareMount(const SharePtr &share, int *fd, QVariantMap &mountArguments);
+
+    /**
+     * Start the mount job for the share @p share. Returns FALSE if the
+     * share was not mounted, e.g. because it is already mounted.
+     *
+     * @param share           The share
+     */
+    bool startMountJob(const SharePtr &share);
+
+    /**
+     * Start one job that mounts all shares in @p shares through a single
+     * invocation of the mount helper. Returns FALSE if none of the shares
+     * needed to be mounted.
+     *
+     * @param shares          The list of shares
+     */
+    bool startMountBatchJob(const QList<SharePtr> &shares);
+
+    /**
+     * Process the result of a finished mount job.
+     *
+     * @param job             The mount job
+     *
+     * @param share           The share that was to be mounted
+     *
+     * @param fileDescriptor  The file descriptor passed to the helper or -1
+     */
+    void finishMountJob(KJob *job, const SharePtr &share, int fileDescriptor);
+
+    /**
+     * Process the result of a finished batch mount job.
+     *
+     * @param job             The mount job
+     *
+     * @param shares          The shares that were to be mounted
+     *
+     * @param fileDescriptor  The file descriptor passed to the helper or -1
+     */
+    void finishMountBatchJob(KJob *job, const QList<SharePtr> &shares, int fileDescriptor);
+
+    /**
+     * Process the error message the mount command reported for the share
+     * @p share. Authentication errors lead to a request for credentials.
+     *
+     * @param share           The share
+     *
+     * @param errorMsg        The error message
+     */
+    void processMountError(const SharePtr &share, const QString &errorMsg);
+
+    /**
+     * Finish the running batch of mounts and notify the user about the
+     * newly mounted shares.
+     */
+    void finishMountBatch();
+
     /**
      * Fill the mount action arguments into a map.
      */
@@ -271,9 +436,49 @@ private:
     bool fillUnmountActionArgs(const SharePtr &share, bool force, bool silent, QVariantMap &unmountArgs);
 
     /**
-     * Check the size, accessibility, ids, etc. of the share(s)
+     * Check the size, accessibility, ids, etc. of the newly mounted share
+     * @p share as soon as possible. The check is done in a worker thread.
+     *
+     * @param share           The share
+     */
+    void checkMountedShare(const SharePtr &share);
+
+    /**
+     * Returns TRUE if the check of the share @p share can be started
+     * right away without queuing it or blocking the checks of the other
+     * servers.
+     */
+    bool canStartMountedShareCheck(const SharePtr &share) const;
+
+    /**
+     * Start the checks of the mounted shares that are due within the
+     * configured budget. Shares that did not change are checked less
+     * often and the checks are spread over time.
+     */
+    void scheduleMountedShareChecks();
+
+    /**
+     * Check all mounted shares at the shortest interval again.
+     */
+    void resetCheckSchedules();
+
+    /**
+     * Start the check of the mounted share @p share in a worker thread.
+     *
+     * @param share           The share
+     */
+    void startMountedShareCheck(const SharePtr &share);
+
+    /**
+     * Process the result of the check of the share mounted at @p path. The
+     * updated() signal is only emitted if something changed.
+     */
+    void finishMountedShareCheck(const QString &path, const Smb4KMountPointState &state);
+
+    /**
+     * Mark the shares whose check did not return in time as inaccessible.
      */
-    void checkMountedShare(const SharePtr &share) const;
+    void checkHungShares();
 
     /**
      * Create mount point
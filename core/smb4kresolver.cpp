@@ -0,0 +1,255 @@
+/*
+    This class provides the host name resolution used by Smb4K
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kresolver.h"
+#include "smb4kglobal.h"
+#include "smb4khardwareinterface.h"
+
+// Qt includes
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
+#include <QApplicationStatic>
+#else
+#include <qapplicationstatic.h>
+#endif
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QHostInfo>
+#include <QMutex>
+#include <QNetworkInterface>
+#include <QSet>
+
+#define POSITIVE_TTL 300000
+#define NEGATIVE_TTL 30000
+#define MAX_CONCURRENT_LOOKUPS 16
+
+using namespace Smb4KGlobal;
+
+class Smb4KResolverStatic
+{
+public:
+    Smb4KResolver instance;
+};
+
+class Smb4KResolverPrivate
+{
+public:
+    struct CacheEntry {
+        QHostAddress address;
+        QDeadlineTimer expiry;
+    };
+    QHash<QString, CacheEntry> cache;
+    QStringList queue;
+    QSet<QString> runningLookups;
+    quint64 hits;
+    quint64 misses;
+    QMutex mutex;
+};
+
+Q_APPLICATION_STATIC(Smb4KResolverStatic, p);
+
+Smb4KResolver::Smb4KResolver(QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KResolverPrivate)
+{
+    d->hits = 0;
+    d->misses = 0;
+
+    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::onlineStateChanged, this, &Smb4KResolver::slotOnlineStateChanged);
+    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkAddressesChanged, this, &Smb4KResolver::slotNetworkAddressesChanged);
+}
+
+Smb4KResolver::~Smb4KResolver()
+{
+}
+
+Smb4KResolver *Smb4KResolver::self()
+{
+    return &p->instance;
+}
+
+QHostAddress Smb4KResolver::lookupIpAddress(const QString &name)
+{
+    QHostAddress address;
+
+    if (cachedIpAddress(name, &address)) {
+        return address;
+    }
+
+    //
+    // If the IP address is not to be determined for the local machine, we can use QHostInfo to
+    // determine it. Otherwise we need to use QNetworkInterface for it.
+    //
+    if (isLocalHostName(name)) {
+        // FIXME: Do we need to honor 'interfaces' here?
+        address = preferredIpAddress(QNetworkInterface::allAddresses());
+    } else {
+        QHostInfo hostInfo = QHostInfo::fromName(name);
+
+        if (hostInfo.error() == QHostInfo::NoError) {
+            address = preferredIpAddress(hostInfo.addresses());
+        }
+    }
+
+    insert(name, address);
+
+    return address;
+}
+
+bool Smb4KResolver::cachedIpAddress(const QString &name, QHostAddress *address)
+{
+    QMutexLocker locker(&d->mutex);
+
+    auto it = d->cache.constFind(name.toUpper());
+
+    if (it != d->cache.constEnd() && !it->expiry.hasExpired()) {
+        *address = it->address;
+        d->hits++;
+        return true;
+    }
+
+    d->misses++;
+
+    return false;
+}
+
+void Smb4KResolver::resolve(const QString &name)
+{
+    QString key = name.toUpper();
+
+    if (!d->runningLookups.contains(key) && !d->queue.contains(key)) {
+        d->queue << key;
+        startLookups();
+    }
+}
+
+void Smb4KResolver::invalidate()
+{
+    QMutexLocker locker(&d->mutex);
+    d->cache.clear();
+}
+
+quint64 Smb4KResolver::cacheHits() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->hits;
+}
+
+quint64 Smb4KResolver::cacheMisses() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->misses;
+}
+
+QHostAddress Smb4KResolver::preferredIpAddress(const QList<QHostAddress> &addresses)
+{
+    QHostAddress ipAddress;
+
+    // Get the IP address for the host. For the time being, prefer the
+    // IPv4 address over the IPv6 address.
+    for (const QHostAddress &addr : addresses) {
+        // We only use global addresses.
+        if (addr.isGlobal()) {
+            if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
+                ipAddress = addr;
+                break;
+            } else if (addr.protocol() == QAbstractSocket::IPv6Protocol) {
+                // FIXME: Use the right address here.
+                ipAddress = addr;
+            }
+        }
+    }
+
+    return ipAddress;
+}
+
+bool Smb4KResolver::isLocalHostName(const QString &name)
+{
+    return QString::compare(name, QHostInfo::localHostName(), Qt::CaseInsensitive) == 0
+        || QString::compare(name, machineNetbiosName(), Qt::CaseInsensitive) == 0;
+}
+
+void Smb4KResolver::startLookups()
+{
+    while (d->runningLookups.size() < MAX_CONCURRENT_LOOKUPS && !d->queue.isEmpty()) {
+        QString name = d->queue.takeFirst();
+
+        //
+        // The local machine is resolved without asking the network
+        //
+        if (isLocalHostName(name)) {
+            Q_EMIT ipAddressResolved(name, lookupIpAddress(name));
+            continue;
+        }
+
+        d->runningLookups.insert(name);
+
+        QHostInfo::lookupHost(name, this, [this, name](const QHostInfo &hostInfo) {
+            processHostInfo(name, hostInfo);
+        });
+    }
+}
+
+void Smb4KResolver::processHostInfo(const QString &name, const QHostInfo &hostInfo)
+{
+    d->runningLookups.remove(name);
+
+    QHostAddress address;
+
+    if (hostInfo.error() == QHostInfo::NoError) {
+        address = preferredIpAddress(hostInfo.addresses());
+    }
+
+    insert(name, address);
+
+    Q_EMIT ipAddressResolved(name, address);
+
+    startLookups();
+}
+
+void Smb4KResolver::insert(const QString &name, const QHostAddress &address)
+{
+    Smb4KResolverPrivate::CacheEntry entry;
+    entry.address = address;
+    entry.expiry.setRemainingTime(address.isNull() ? NEGATIVE_TTL : POSITIVE_TTL);
+
+    QMutexLocker locker(&d->mutex);
+    d->cache.insert(name.toUpper(), entry);
+}
+
+void Smb4KResolver::slotOnlineStateChanged(bool online)
+{
+    Q_UNUSED(online);
+
+    //
+    // Addresses might have changed or names might resolve now that did
+    // not before.
+    //
+    invalidate();
+}
+
+void Smb4KResolver::slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed)
+{
+    Q_UNUSED(added);
+    Q_UNUSED(removed);
+
+    //
+    // Names that did not resolve might resolve through the changed network.
+    // The addresses that were resolved stay valid.
+    //
+    QMutexLocker locker(&d->mutex);
+
+    auto it = d->cache.begin();
+
+    while (it != d->cache.end()) {
+        if (it->address.isNull()) {
+            it = d->cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
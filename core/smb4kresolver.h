@@ -0,0 +1,164 @@
+/*
+    This class provides the host name resolution used by Smb4K
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KRESOLVER_H
+#define SMB4KRESOLVER_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+
+// Qt includes
+#include <QHostAddress>
+#include <QNetworkAddressEntry>
+#include <QObject>
+#include <QScopedPointer>
+
+// forward declarations
+class QHostInfo;
+class Smb4KResolverPrivate;
+
+/**
+ * This class resolves host names to IP addresses and caches the results
+ * process-wide. Successful lookups are kept for a few minutes, failed ones
+ * for a shorter time. The cache is cleared when the online state of the
+ * system changes.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.1.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     */
+    explicit Smb4KResolver(QObject *parent = nullptr);
+
+    /**
+     * Destructor
+     */
+    ~Smb4KResolver();
+
+    /**
+     * This is a static pointer to this class.
+     */
+    static Smb4KResolver *self();
+
+    /**
+     * Look up the IP address of the host @p name. If the result is not
+     * cached, this function blocks until the name was resolved. This
+     * function may be called from any thread.
+     *
+     * @param name          The host name
+     *
+     * @returns the IP address or a null address if the name could not be
+     * resolved.
+     */
+    QHostAddress lookupIpAddress(const QString &name);
+
+    /**
+     * Get the IP address of the host @p name from the cache. Nothing is
+     * resolved by this function.
+     *
+     * @param name          The host name
+     *
+     * @param address       The cached IP address. It is null if the name is
+     *                      known not to resolve.
+     *
+     * @returns TRUE if a valid cache entry was found.
+     */
+    bool cachedIpAddress(const QString &name, QHostAddress *address);
+
+    /**
+     * Resolve the host name @p name asynchronously. The result is reported
+     * by the ipAddressResolved() signal. Only a limited number of lookups
+     * run at the same time and each name is only resolved once, even if it
+     * is requested several times.
+     *
+     * @param name          The host name
+     */
+    void resolve(const QString &name);
+
+    /**
+     * Clear the cache
+     */
+    void invalidate();
+
+    /**
+     * Returns the number of lookups that were answered from the cache
+     */
+    quint64 cacheHits() const;
+
+    /**
+     * Returns the number of lookups that were not answered from the cache
+     */
+    quint64 cacheMisses() const;
+
+    /**
+     * Pick the address that should be used for a host from the list of
+     * resolved addresses. Global IPv4 addresses are preferred.
+     *
+     * @param addresses     The list of addresses
+     *
+     * @returns the preferred address or a null address.
+     */
+    static QHostAddress preferredIpAddress(const QList<QHostAddress> &addresses);
+
+    /**
+     * Returns TRUE if @p name is the name of the local machine.
+     */
+    static bool isLocalHostName(const QString &name);
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when a host name that was passed to resolve()
+     * has been resolved.
+     *
+     * @param name          The host name in upper case
+     *
+     * @param address       The IP address or a null address on failure
+     */
+    void ipAddressResolved(const QString &name, const QHostAddress &address);
+
+protected Q_SLOTS:
+    /**
+     * Called when the online state of the system changed
+     */
+    void slotOnlineStateChanged(bool online);
+
+    /**
+     * Called when IP addresses were assigned to or removed from the network
+     * interfaces
+     */
+    void slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed);
+
+private:
+    /**
+     * Start queued lookups
+     */
+    void startLookups();
+
+    /**
+     * Process the result of an asynchronous lookup
+     */
+    void processHostInfo(const QString &name, const QHostInfo &hostInfo);
+
+    /**
+     * Store a result in the cache
+     */
+    void insert(const QString &name, const QHostAddress &address);
+
+    /**
+     * Pointer to the Smb4KResolverPrivate class
+     */
+    const QScopedPointer<Smb4KResolverPrivate> d;
+};
+
+#endif
@@ -0,0 +1,244 @@
+/*
+    This class checks asynchronously if servers are reachable
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kserverprobe.h"
+#include "smb4khardwareinterface.h"
+#include "smb4kresolver.h"
+
+// Qt includes
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 8, 0))
+#include <QApplicationStatic>
+#else
+#include <qapplicationstatic.h>
+#endif
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QSet>
+#include <QTcpSocket>
+#include <QTimer>
+
+#define SMB_PORT 445
+#define PROBE_TIMEOUT 3000
+#define POSITIVE_TTL 60000
+#define NEGATIVE_TTL 15000
+#define MAX_CONCURRENT_PROBES 16
+
+class Smb4KServerProbeStatic
+{
+public:
+    Smb4KServerProbe instance;
+};
+
+class Smb4KServerProbePrivate
+{
+public:
+    struct CacheEntry {
+        QHostAddress address;
+        bool reachable;
+        QDeadlineTimer expiry;
+    };
+    QHash<QString, CacheEntry> cache;
+    QStringList queue;
+    QHash<QString, QHostAddress> addresses;
+    QSet<QString> resolving;
+    QHash<QString, QTcpSocket *> runningProbes;
+};
+
+Q_APPLICATION_STATIC(Smb4KServerProbeStatic, p);
+
+Smb4KServerProbe::Smb4KServerProbe(QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KServerProbePrivate)
+{
+    connect(Smb4KResolver::self(), &Smb4KResolver::ipAddressResolved, this, &Smb4KServerProbe::slotIpAddressResolved);
+    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::onlineStateChanged, this, &Smb4KServerProbe::slotOnlineStateChanged);
+    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkAddressesChanged, this, &Smb4KServerProbe::slotNetworkAddressesChanged);
+}
+
+Smb4KServerProbe::~Smb4KServerProbe()
+{
+}
+
+Smb4KServerProbe *Smb4KServerProbe::self()
+{
+    return &p->instance;
+}
+
+void Smb4KServerProbe::probe(const QString &hostName, const QString &ipAddress)
+{
+    QString key = hostName.toUpper();
+    bool reachable = false;
+
+    //
+    // Report cached results asynchronously, so that the caller always
+    // gets the result the same way
+    //
+    if (cachedResult(key, &reachable)) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, key, reachable]() {
+                Q_EMIT probeFinished(key, reachable);
+            },
+            Qt::QueuedConnection);
+        return;
+    }
+
+    if (d->runningProbes.contains(key) || d->resolving.contains(key) || d->queue.contains(key)) {
+        return;
+    }
+
+    QHostAddress address;
+
+    if (!ipAddress.isEmpty()) {
+        address.setAddress(ipAddress);
+    } else if (!Smb4KResolver::self()->cachedIpAddress(key, &address)) {
+        d->resolving.insert(key);
+        Smb4KResolver::self()->resolve(key);
+        return;
+    }
+
+    // The host name is known not to resolve. Handle it like a failed lookup.
+    if (address.isNull()) {
+        d->resolving.insert(key);
+        QMetaObject::invokeMethod(
+            this,
+            [this, key]() {
+                finishProbe(key, false);
+            },
+            Qt::QueuedConnection);
+        return;
+    }
+
+    d->addresses.insert(key, address);
+    d->queue << key;
+
+    startProbes();
+}
+
+bool Smb4KServerProbe::cachedResult(const QString &hostName, bool *reachable) const
+{
+    auto it = d->cache.constFind(hostName.toUpper());
+
+    if (it != d->cache.constEnd() && !it->expiry.hasExpired()) {
+        *reachable = it->reachable;
+        return true;
+    }
+
+    return false;
+}
+
+void Smb4KServerProbe::invalidate()
+{
+    d->cache.clear();
+}
+
+void Smb4KServerProbe::startProbes()
+{
+    while (d->runningProbes.size() < MAX_CONCURRENT_PROBES && !d->queue.isEmpty()) {
+        QString key = d->queue.takeFirst();
+        QHostAddress address = d->addresses.value(key);
+
+        QTcpSocket *socket = new QTcpSocket(this);
+        d->runningProbes.insert(key, socket);
+
+        connect(socket, &QTcpSocket::connected, this, [this, key]() {
+            finishProbe(key, true);
+        });
+
+        connect(socket, &QTcpSocket::errorOccurred, this, [this, key]() {
+            finishProbe(key, false);
+        });
+
+        // Each server gets its own timeout
+        QTimer::singleShot(PROBE_TIMEOUT, socket, [this, key]() {
+            finishProbe(key, false);
+        });
+
+        socket->connectToHost(address, SMB_PORT);
+    }
+}
+
+void Smb4KServerProbe::finishProbe(const QString &hostName, bool reachable)
+{
+    //
+    // The probe might have been finished before, e.g. when the connection
+    // failed shortly before the timeout
+    //
+    if (QTcpSocket *socket = d->runningProbes.take(hostName)) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    } else if (!d->resolving.remove(hostName)) {
+        return;
+    }
+
+    Smb4KServerProbePrivate::CacheEntry entry;
+    entry.address = d->addresses.take(hostName);
+    entry.reachable = reachable;
+    entry.expiry.setRemainingTime(reachable ? POSITIVE_TTL : NEGATIVE_TTL);
+    d->cache.insert(hostName, entry);
+
+    Q_EMIT probeFinished(hostName, reachable);
+
+    startProbes();
+}
+
+void Smb4KServerProbe::slotIpAddressResolved(const QString &name, const QHostAddress &address)
+{
+    if (!d->resolving.contains(name)) {
+        return;
+    }
+
+    if (address.isNull()) {
+        finishProbe(name, false);
+        return;
+    }
+
+    d->resolving.remove(name);
+    d->addresses.insert(name, address);
+    d->queue << name;
+
+    startProbes();
+}
+
+void Smb4KServerProbe::slotOnlineStateChanged(bool online)
+{
+    Q_UNUSED(online);
+
+    //
+    // Servers that were not reachable before might be now and vice versa
+    //
+    invalidate();
+}
+
+void Smb4KServerProbe::slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed)
+{
+    //
+    // Servers that were not reachable might be reachable through the new
+    // addresses. Servers in the subnets of removed addresses might not be
+    // reachable anymore.
+    //
+    auto it = d->cache.begin();
+
+    while (it != d->cache.end()) {
+        bool obsolete = !it->reachable && !added.isEmpty();
+
+        for (const QNetworkAddressEntry &entry : removed) {
+            if (it->reachable && it->address.isInSubnet(entry.ip(), entry.prefixLength())) {
+                obsolete = true;
+                break;
+            }
+        }
+
+        if (obsolete) {
+            it = d->cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
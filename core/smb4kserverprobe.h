@@ -0,0 +1,128 @@
+/*
+    This class checks asynchronously if servers are reachable
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KSERVERPROBE_H
+#define SMB4KSERVERPROBE_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+
+// Qt includes
+#include <QHostAddress>
+#include <QNetworkAddressEntry>
+#include <QObject>
+#include <QScopedPointer>
+
+// forward declarations
+class Smb4KServerProbePrivate;
+
+/**
+ * This class checks if servers accept connections on the SMB port. The
+ * servers are probed in parallel, each with its own timeout, and the
+ * results are cached for a short time. The cache is cleared when the
+ * online state of the system changes.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.1.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KServerProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     */
+    explicit Smb4KServerProbe(QObject *parent = nullptr);
+
+    /**
+     * Destructor
+     */
+    ~Smb4KServerProbe();
+
+    /**
+     * This is a static pointer to this class.
+     */
+    static Smb4KServerProbe *self();
+
+    /**
+     * Check asynchronously if the server @p hostName is reachable. If the
+     * IP address @p ipAddress is empty, the host name is resolved first.
+     * The result is reported by the probeFinished() signal, also if it was
+     * taken from the cache. A server that is already being probed is not
+     * probed a second time.
+     *
+     * @param hostName      The host name
+     *
+     * @param ipAddress     The IP address of the host or an empty string
+     */
+    void probe(const QString &hostName, const QString &ipAddress = QString());
+
+    /**
+     * Get the result of a recent probe of the server @p hostName from the
+     * cache. Nothing is probed by this function.
+     *
+     * @param hostName      The host name
+     *
+     * @param reachable     TRUE if the server was reachable
+     *
+     * @returns TRUE if a valid cache entry was found.
+     */
+    bool cachedResult(const QString &hostName, bool *reachable) const;
+
+    /**
+     * Clear the cache
+     */
+    void invalidate();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when a server that was passed to probe()
+     * has been probed.
+     *
+     * @param hostName      The host name in upper case
+     *
+     * @param reachable     TRUE if the server accepted the connection
+     */
+    void probeFinished(const QString &hostName, bool reachable);
+
+protected Q_SLOTS:
+    /**
+     * Called when a host name was resolved
+     */
+    void slotIpAddressResolved(const QString &name, const QHostAddress &address);
+
+    /**
+     * Called when the online state of the system changed
+     */
+    void slotOnlineStateChanged(bool online);
+
+    /**
+     * Called when IP addresses were assigned to or removed from the network
+     * interfaces
+     */
+    void slotNetworkAddressesChanged(const QList<QNetworkAddressEntry> &added, const QList<QNetworkAddressEntry> &removed);
+
+private:
+    /**
+     * Start queued probes
+     */
+    void startProbes();
+
+    /**
+     * Finish the probe of the server @p hostName and report the result
+     */
+    void finishProbe(const QString &hostName, bool reachable);
+
+    /**
+     * Pointer to the Smb4KServerProbePrivate class
+     */
+    const QScopedPointer<Smb4KServerProbePrivate> d;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+    This class provides a binary cache for the XML files
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4ksnapshotcache.h"
+
+// Qt includes
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#define SNAPSHOT_MAGIC 0x534D424B
+#define SNAPSHOT_VERSION 1
+
+Smb4KSnapshotCache::Smb4KSnapshotCache(const QString &sourceFileName, quint32 formatVersion)
+    : m_sourceFileName(sourceFileName)
+    , m_formatVersion(formatVersion)
+{
+    QFileInfo sourceInfo(sourceFileName);
+    m_fileName = sourceInfo.path() + QDir::separator() + sourceInfo.completeBaseName() + QStringLiteral(".cache");
+}
+
+Smb4KSnapshotCache::~Smb4KSnapshotCache()
+{
+}
+
+bool Smb4KSnapshotCache::load(const ReadFunction &readFunction) const
+{
+    QFileInfo sourceInfo(m_sourceFileName);
+
+    if (!sourceInfo.exists()) {
+        return false;
+    }
+
+    QFile file(m_fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0, version = 0, formatVersion = 0;
+    qint64 lastModified = 0, size = 0;
+
+    stream >> magic >> version >> formatVersion >> lastModified >> size;
+
+    //
+    // The snapshot is outdated, if the XML file was modified since it was
+    // taken
+    //
+    if (stream.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION || formatVersion != m_formatVersion
+        || lastModified != sourceInfo.lastModified().toMSecsSinceEpoch() || size != sourceInfo.size()) {
+        return false;
+    }
+
+    return readFunction(stream) && stream.status() == QDataStream::Ok;
+}
+
+void Smb4KSnapshotCache::save(const WriteFunction &writeFunction) const
+{
+    QFileInfo sourceInfo(m_sourceFileName);
+
+    if (!sourceInfo.exists()) {
+        remove();
+        return;
+    }
+
+    QSaveFile file(m_fileName);
+
+    if (file.open(QIODevice::WriteOnly)) {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_6_0);
+
+        stream << quint32(SNAPSHOT_MAGIC) << quint32(SNAPSHOT_VERSION) << m_formatVersion;
+        stream << qint64(sourceInfo.lastModified().toMSecsSinceEpoch()) << qint64(sourceInfo.size());
+
+        writeFunction(stream);
+
+        if (stream.status() == QDataStream::Ok) {
+            file.commit();
+        } else {
+            file.cancelWriting();
+        }
+    }
+}
+
+void Smb4KSnapshotCache::remove() const
+{
+    QFile::remove(m_fileName);
+}
@@ -0,0 +1,90 @@
+/*
+    This class provides a binary cache for the XML files
+
+    SPDX-FileCopyrightText: 2026 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KSNAPSHOTCACHE_H
+#define SMB4KSNAPSHOTCACHE_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+
+// Qt includes
+#include <QString>
+
+// system includes
+#include <functional>
+
+// forward declarations
+class QDataStream;
+
+/**
+ * This class keeps a binary snapshot of the data stored in an XML file
+ * next to it. The snapshot is only valid as long as the modification time
+ * and the size of the XML file did not change. The XML file stays the
+ * source of truth, the snapshot only speeds up loading it.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.1.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KSnapshotCache
+{
+public:
+    /**
+     * The function that reads the data from the stream. It returns FALSE
+     * if the data is corrupted.
+     */
+    using ReadFunction = std::function<bool(QDataStream &stream)>;
+
+    /**
+     * The function that writes the data to the stream.
+     */
+    using WriteFunction = std::function<void(QDataStream &stream)>;
+
+    /**
+     * Constructor
+     *
+     * @param sourceFileName  The path of the XML file
+     *
+     * @param formatVersion   The version of the format of the data. A
+     *                        snapshot with another version is not loaded.
+     */
+    Smb4KSnapshotCache(const QString &sourceFileName, quint32 formatVersion);
+
+    /**
+     * Destructor
+     */
+    ~Smb4KSnapshotCache();
+
+    /**
+     * Load the snapshot, if it is valid for the current XML file.
+     *
+     * @param readFunction    The function that reads the data
+     *
+     * @returns TRUE if the snapshot was valid and was read successfully.
+     */
+    bool load(const ReadFunction &readFunction) const;
+
+    /**
+     * Take a new snapshot of the data for the current XML file. If the XML
+     * file does not exist, the snapshot is removed.
+     *
+     * @param writeFunction   The function that writes the data
+     */
+    void save(const WriteFunction &writeFunction) const;
+
+    /**
+     * Remove the snapshot.
+     */
+    void remove() const;
+
+private:
+    QString m_sourceFileName;
+    QString m_fileName;
+    quint32 m_formatVersion;
+};
+
+#endif
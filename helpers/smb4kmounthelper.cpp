@@ -12,8 +12,10 @@
 // Qt includes
 #include <QDebug>
 #include <QDir>
+#include <QEventLoop>
 #include <QNetworkInterface>
 #include <QProcessEnvironment>
+#include <QTimer>
 #include <QUrl>
 
 // KDE includes
@@ -30,6 +32,11 @@ using namespace Smb4KGlobal;
 
 KAUTH_HELPER_MAIN("org.kde.smb4k.mounthelper", Smb4KMountHelper);
 
+#define DEFAULT_TIMEOUT 30000
+#define MIN_TIMEOUT 5000
+#define MAX_TIMEOUT 300000
+#define STOP_CHECK_INTERVAL 250
+
 static const QStringList MOUNT_ARG_WHITELIST{QStringList{
 #if defined(Q_OS_LINUX)
     QStringLiteral("domain"),      QStringLiteral("ip"),         QStringLiteral("username"),    QStringLiteral("guest"),
@@ -68,25 +75,161 @@ KAuth::ActionReply Smb4KMountHelper::mount(const QVariantMap &args)
         return errorReply(i18n("The computer is not online."));
     }
 
+    QList<SupervisedProcess> processes(1);
+    QString errorDescription;
+
+    if (!startMountProcess(args, &processes[0], &errorDescription)) {
+        return errorReply(errorDescription);
+    }
+
+    superviseProcesses(processes, processTimeout(args));
+
+    if (processes.at(0).process->exitStatus() == KProcess::NormalExit) {
+        QString stdErr = QString::fromUtf8(processes.at(0).standardError);
+        reply.addData(QStringLiteral("mh_error_message"), stdErr.trimmed());
+    }
+
+    delete processes.at(0).process;
+
+    return reply;
+}
+
+KAuth::ActionReply Smb4KMountHelper::mountbatch(const QVariantMap &args)
+{
+    ActionReply reply;
+
+    if (!isOnline()) {
+        return errorReply(i18n("The computer is not online."));
+    }
+
+    const QVariantList shares = args[QStringLiteral("mh_shares")].toList();
+    QList<SupervisedProcess> processes(shares.size());
+    QStringList errorDescriptions;
+
+    for (int i = 0; i < shares.size(); ++i) {
+        QVariantMap shareArgs = shares.at(i).toMap();
+
+        // The Kerberos ticket is the same for all shares
+        if (args.contains(QStringLiteral("mh_krb5ticket"))) {
+            shareArgs.insert(QStringLiteral("mh_krb5ticket"), args[QStringLiteral("mh_krb5ticket")]);
+        }
+
+        QString errorDescription;
+        startMountProcess(shareArgs, &processes[i], &errorDescription);
+        errorDescriptions << errorDescription;
+    }
+
+    superviseProcesses(processes, processTimeout(args));
+
+    QVariantList results;
+
+    for (int i = 0; i < processes.size(); ++i) {
+        QVariantMap result;
+
+        if (!processes.at(i).process) {
+            result.insert(QStringLiteral("mh_error_description"), errorDescriptions.at(i));
+        } else {
+            if (processes.at(i).process->exitStatus() == KProcess::NormalExit) {
+                result.insert(QStringLiteral("mh_error_message"), QString::fromUtf8(processes.at(i).standardError).trimmed());
+            }
+
+            delete processes.at(i).process;
+        }
+
+        results << result;
+    }
+
+    reply.addData(QStringLiteral("mh_results"), results);
+
+    return reply;
+}
+
+KAuth::ActionReply Smb4KMountHelper::unmount(const QVariantMap &args)
+{
+    ActionReply reply;
+
+    QString mountPoint = args[QStringLiteral("mh_mountpoint")].toString();
+
+    if (!isMountPointAllowed(mountPoint)) {
+        return errorReply(i18n("The mountpoint %1 is illegal.", args[QStringLiteral("mh_mountpoint")].toString()));
+    }
+
+    const QString umount = findUmountExecutable();
+
+    if (umount.isEmpty()) {
+        return errorReply(i18n("The umount command could not be found."));
+    }
+
+    QStringList unmountOptions = args[QStringLiteral("mh_options")].toStringList();
+
+    if (!checkUnmountArguments(&unmountOptions)) {
+        return errorReply(i18n("Forbidden unmount options were passed."));
+    }
+
+    QStringList command;
+    command << umount;
+    command << unmountOptions;
+    command << QDir(mountPoint).canonicalPath();
+
+    KProcess proc(this);
+    proc.setOutputChannelMode(KProcess::SeparateChannels);
+    proc.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
+    proc.setProgram(command);
+
+    // Depending on the online state, use a different behavior for unmounting.
+    //
+    // Extensive tests have shown that - when offline - unmounting does not
+    // work properly when the process is not detached. Thus, detach it when
+    // the system is offline.
+    if (isOnline()) {
+        proc.start();
+
+        if (proc.waitForStarted(-1)) {
+            QList<SupervisedProcess> processes(1);
+            processes[0].process = &proc;
+
+            superviseProcesses(processes, processTimeout(args));
+
+            if (proc.exitStatus() == KProcess::NormalExit) {
+                QString stdErr = QString::fromUtf8(processes.at(0).standardError);
+                reply.addData(QStringLiteral("mh_error_message"), stdErr.trimmed());
+            }
+        } else {
+            return errorReply(i18n("The unmount process could not be started."));
+        }
+    } else {
+        proc.startDetached();
+    }
+
+    removeMountPoint(QDir(mountPoint).canonicalPath());
+
+    return reply;
+}
+
+bool Smb4KMountHelper::startMountProcess(const QVariantMap &args, SupervisedProcess *supervisedProcess, QString *errorDescription)
+{
     QString mountPoint;
     QUrl shareUrl = args[QStringLiteral("mh_url")].toUrl();
 
     if (auto mp = createMountPoint(shareUrl)) {
         mountPoint = *mp;
     } else {
-        return errorReply(i18n("Could not create mount point for share %1.", shareUrl.toDisplayString()));
+        *errorDescription = i18n("Could not create mount point for share %1.", shareUrl.toDisplayString());
+        return false;
     }
 
     const QString mount = findMountExecutable();
 
     if (mount.isEmpty()) {
-        return errorReply(i18n("The mount command could not be found."));
+        *errorDescription = i18n("The mount command could not be found.");
+        return false;
     }
 
     QStringList mountOptions = args[QStringLiteral("mh_options")].toStringList();
 
     if (!checkMountArguments(&mountOptions)) {
-        return errorReply(i18n("Forbidden mount options were passed."));
+        *errorDescription = i18n("Forbidden mount options were passed.");
+        return false;
     }
 
     if (args.contains(QStringLiteral("mh_use_ids")) && args[QStringLiteral("mh_use_ids")].toBool()) {
@@ -121,14 +264,14 @@ KAuth::ActionReply Smb4KMountHelper::mount(const QVariantMap &args)
     command << mountPoint;
 #endif
 
-    KProcess proc(this);
-    proc.setOutputChannelMode(KProcess::SeparateChannels);
-    proc.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
+    KProcess *proc = new KProcess(this);
+    proc->setOutputChannelMode(KProcess::SeparateChannels);
+    proc->setProcessEnvironment(QProcessEnvironment::systemEnvironment());
 #if defined(Q_OS_LINUX)
-    proc.setEnv(QStringLiteral("PASSWD"), args[QStringLiteral("mh_url")].toUrl().password(), true);
+    proc->setEnv(QStringLiteral("PASSWD"), shareUrl.password(), true);
 #elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
     // We need this to avoid a translated password prompt.
-    proc.setEnv(QStringLiteral("LANG"), QStringLiteral("C"));
+    proc->setEnv(QStringLiteral("LANG"), QStringLiteral("C"));
 #endif
     // If the location of a Kerberos ticket is passed, it needs to
     // be passed to the process environment here.
@@ -136,122 +279,113 @@ KAuth::ActionReply Smb4KMountHelper::mount(const QVariantMap &args)
         auto ticketFd = args[QStringLiteral("mh_krb5ticket")].value<QDBusUnixFileDescriptor>();
 
         if (!checkFileDescriptor(ticketFd)) {
-            return errorReply(i18n("There is something wrong with the provided Kerberos ticket."));
+            delete proc;
+            *errorDescription = i18n("There is something wrong with the provided Kerberos ticket.");
+            return false;
         }
 
         QString krb5ccFile = QString(QStringLiteral("/proc/self/fd/%1")).arg(ticketFd.fileDescriptor());
-        proc.setEnv(QStringLiteral("KRB5CCNAME"), krb5ccFile);
+        proc->setEnv(QStringLiteral("KRB5CCNAME"), krb5ccFile);
     }
 
-    proc.setProgram(command);
-    proc.start();
-
-    if (proc.waitForStarted(-1)) {
-        int timeout = 0;
-
-        while (proc.state() != KProcess::NotRunning) {
-            // We want to be able to terminate the process from outside.
-            // Thus, we implement a loop that checks periodically, if we
-            // need to kill the process. It is non-blocking.
-            if (HelperSupport::isStopped() || timeout == 30000) {
-                proc.kill();
-                break;
-            }
-#if defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
-            // Check if there is a password prompt. If there is one, pass
-            // the password to it.
-            QByteArray out = proc.readAllStandardError();
-
-            if (out.startsWith("Password")) {
-                proc.write(args[QStringLiteral("mh_url")].toUrl().password().toUtf8().data());
-                proc.write("\r");
-            }
-#endif
-            timeout += 10;
-            wait(10);
-        }
+    proc->setProgram(command);
+    proc->start();
 
-        if (proc.exitStatus() == KProcess::NormalExit) {
-            QString stdErr = QString::fromUtf8(proc.readAllStandardError());
-            reply.addData(QStringLiteral("mh_error_message"), stdErr.trimmed());
-        }
-    } else {
-        return errorReply(i18n("The mount process could not be started."));
+    if (!proc->waitForStarted(-1)) {
+        delete proc;
+        *errorDescription = i18n("The mount process could not be started.");
+        return false;
     }
 
-    return reply;
+    supervisedProcess->process = proc;
+    supervisedProcess->password = shareUrl.password();
+
+    return true;
 }
 
-KAuth::ActionReply Smb4KMountHelper::unmount(const QVariantMap &args)
+void Smb4KMountHelper::superviseProcesses(QList<SupervisedProcess> &processes, int timeout)
 {
-    ActionReply reply;
+    QEventLoop loop;
+    int runningProcesses = 0;
 
-    QString mountPoint = args[QStringLiteral("mh_mountpoint")].toString();
-
-    if (!isMountPointAllowed(mountPoint)) {
-        return errorReply(i18n("The mountpoint %1 is illegal.", args[QStringLiteral("mh_mountpoint")].toString()));
-    }
+    for (SupervisedProcess &supervisedProcess : processes) {
+        if (!supervisedProcess.process || supervisedProcess.process->state() == KProcess::NotRunning) {
+            continue;
+        }
 
-    const QString umount = findUmountExecutable();
+        SupervisedProcess *sp = &supervisedProcess;
 
-    if (umount.isEmpty()) {
-        return errorReply(i18n("The umount command could not be found."));
-    }
+        // Collect the error output while the process is running.
+        connect(sp->process, &KProcess::readyReadStandardError, &loop, [sp]() {
+            QByteArray output = sp->process->readAllStandardError();
+#if defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
+            // Check if there is a password prompt. If there is one, pass
+            // the password to it.
+            if (output.startsWith("Password")) {
+                sp->process->write(sp->password.toUtf8().data());
+                sp->process->write("\r");
+                return;
+            }
+#endif
+            sp->standardError += output;
+        });
 
-    QStringList unmountOptions = args[QStringLiteral("mh_options")].toStringList();
+        connect(sp->process, &KProcess::finished, &loop, [&loop, &runningProcesses]() {
+            if (--runningProcesses == 0) {
+                loop.quit();
+            }
+        });
 
-    if (!checkUnmountArguments(&unmountOptions)) {
-        return errorReply(i18n("Forbidden unmount options were passed."));
+        runningProcesses++;
     }
 
-    QStringList command;
-    command << umount;
-    command << unmountOptions;
-    command << QDir(mountPoint).canonicalPath();
+    if (runningProcesses == 0) {
+        return;
+    }
 
-    KProcess proc(this);
-    proc.setOutputChannelMode(KProcess::SeparateChannels);
-    proc.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
-    proc.setProgram(command);
+    // The deadline after which the processes are killed
+    QTimer deadline;
+    deadline.setSingleShot(true);
+    connect(&deadline, &QTimer::timeout, &loop, &QEventLoop::quit);
+    deadline.start(timeout);
+
+    // We want to be able to terminate the processes from outside. The
+    // stop request is not signaled, so check for it periodically.
+    QTimer stopCheck;
+    connect(&stopCheck, &QTimer::timeout, &loop, [&loop]() {
+        if (HelperSupport::isStopped()) {
+            loop.quit();
+        }
+    });
+    stopCheck.start(STOP_CHECK_INTERVAL);
 
-    // Depending on the online state, use a different behavior for unmounting.
-    //
-    // Extensive tests have shown that - when offline - unmounting does not
-    // work properly when the process is not detached. Thus, detach it when
-    // the system is offline.
-    if (isOnline()) {
-        proc.start();
+    loop.exec();
 
-        if (proc.waitForStarted(-1)) {
-            // We want to be able to terminate the process from outside.
-            // Thus, we implement a loop that checks periodically, if we
-            // need to kill the process. It is non-blocking.
-            int timeout = 0;
-
-            while (proc.state() != KProcess::NotRunning) {
-                if (HelperSupport::isStopped() || timeout == 30000) {
-                    proc.kill();
-                    break;
-                }
-
-                timeout += 10;
-                wait(10);
-            }
+    for (SupervisedProcess &supervisedProcess : processes) {
+        if (!supervisedProcess.process) {
+            continue;
+        }
 
-            if (proc.exitStatus() == KProcess::NormalExit) {
-                QString stdErr = QString::fromUtf8(proc.readAllStandardError());
-                reply.addData(QStringLiteral("mh_error_message"), stdErr.trimmed());
-            }
-        } else {
-            return errorReply(i18n("The unmount process could not be started."));
+        if (supervisedProcess.process->state() != KProcess::NotRunning) {
+            supervisedProcess.process->kill();
+            supervisedProcess.process->waitForFinished(-1);
         }
-    } else {
-        proc.startDetached();
+
+        supervisedProcess.process->disconnect(&loop);
+        supervisedProcess.standardError += supervisedProcess.process->readAllStandardError();
     }
+}
 
-    removeMountPoint(QDir(mountPoint).canonicalPath());
+int Smb4KMountHelper::processTimeout(const QVariantMap &args) const
+{
+    //
+    // Do not trust the caller. The processes must neither be stopped
+    // immediately nor be supervised forever.
+    //
+    bool ok = false;
+    int timeout = args.value(QStringLiteral("mh_timeout"), DEFAULT_TIMEOUT).toInt(&ok);
 
-    return reply;
+    return ok ? qBound(MIN_TIMEOUT, timeout, MAX_TIMEOUT) : DEFAULT_TIMEOUT;
 }
 
 bool Smb4KMountHelper::isOnline() const
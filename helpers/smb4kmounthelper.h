@@ -15,6 +15,9 @@
 // KDE includes
 #include <KAuth/ActionReply>
 
+// forward declarations
+class KProcess;
+
 using namespace KAuth;
 
 class Smb4KMountHelper : public QObject
@@ -27,12 +30,29 @@ public Q_SLOTS:
      */
     KAuth::ActionReply mount(const QVariantMap &args);
 
+    /**
+     * Mounts several CIFS/SMBFS shares at once. The arguments of the
+     * shares are passed as a list of argument maps, the Kerberos ticket
+     * and the timeout are passed only once for all shares. The shares are
+     * mounted in parallel and a result is returned for each share in the
+     * order the shares were passed.
+     */
+    KAuth::ActionReply mountbatch(const QVariantMap &args);
+
     /**
      * Unmounts a CIFS/SMBFS share.
      */
     KAuth::ActionReply unmount(const QVariantMap &args);
 
 private:
+    struct SupervisedProcess {
+        KProcess *process = nullptr;
+        QString password;
+        QByteArray standardError;
+    };
+    bool startMountProcess(const QVariantMap &args, SupervisedProcess *supervisedProcess, QString *errorDescription);
+    void superviseProcesses(QList<SupervisedProcess> &processes, int timeout);
+    int processTimeout(const QVariantMap &args) const;
     bool isOnline() const;
     bool checkMountArguments(QStringList *argList) const;
     bool checkUnmountArguments(QStringList *argList) const;
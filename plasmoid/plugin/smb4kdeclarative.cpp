@@ -34,7 +34,9 @@
 //
 // Qt includes
 #include <QDebug>
+#include <QHash>
 #include <QPointer>
+#include <QSet>
 
 // KDE includes
 #include <KConfigDialog>
@@ -42,6 +44,71 @@
 #include <KPluginFactory>
 #include <KPluginMetaData>
 
+//
+// Key identifying a network object
+//
+static QString networkObjectKey(const QString &workgroupName, const QUrl &url)
+{
+    return workgroupName.toCaseFolded() + QStringLiteral("/") + url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded();
+}
+
+//
+// Remove and delete the network objects matching the predicate. Returns TRUE
+// if objects were removed.
+//
+template<class Predicate>
+static bool removeNetworkObjects(QList<Smb4KNetworkObject *> *objects, Predicate isObsolete)
+{
+    QList<Smb4KNetworkObject *> remainingObjects;
+    remainingObjects.reserve(objects->size());
+
+    for (Smb4KNetworkObject *object : std::as_const(*objects)) {
+        if (isObsolete(object)) {
+            delete object;
+        } else {
+            remainingObjects << object;
+        }
+    }
+
+    bool removed = (remainingObjects.size() != objects->size());
+    *objects = remainingObjects;
+
+    return removed;
+}
+
+//
+// Update the network objects of the changed items and append objects
+// for the added ones
+//
+template<class T>
+static void applyNetworkItems(QList<Smb4KNetworkObject *> *objects, const QList<QSharedPointer<T>> &added, const QList<QSharedPointer<T>> &changed)
+{
+    QHash<QString, Smb4KNetworkObject *> index;
+    index.reserve(objects->size() + added.size());
+
+    for (Smb4KNetworkObject *object : std::as_const(*objects)) {
+        index.insert(networkObjectKey(object->workgroupName(), object->url()), object);
+    }
+
+    for (const QSharedPointer<T> &item : changed) {
+        Smb4KNetworkObject *object = index.value(networkObjectKey(item->workgroupName(), item->url()));
+
+        if (object) {
+            object->update(item.data());
+        }
+    }
+
+    for (const QSharedPointer<T> &item : added) {
+        QString key = networkObjectKey(item->workgroupName(), item->url());
+
+        if (!index.contains(key)) {
+            Smb4KNetworkObject *object = new Smb4KNetworkObject(item.data());
+            index.insert(key, object);
+            *objects << object;
+        }
+    }
+}
+
 class Smb4KDeclarativePrivate
 {
 public:
@@ -66,9 +133,9 @@ Smb4KDeclarative::Smb4KDeclarative(QObject *parent)
 
     Smb4KNotification::setComponentName(QStringLiteral("smb4k"));
 
-    connect(Smb4KClient::self(), &Smb4KClient::workgroups, this, &Smb4KDeclarative::slotWorkgroupsListChanged);
-    connect(Smb4KClient::self(), &Smb4KClient::hosts, this, &Smb4KDeclarative::slotHostsListChanged);
-    connect(Smb4KClient::self(), &Smb4KClient::shares, this, &Smb4KDeclarative::slotSharesListChanged);
+    connect(Smb4KClient::self(), &Smb4KClient::workgroupsChanged, this, &Smb4KDeclarative::slotWorkgroupsChanged);
+    connect(Smb4KClient::self(), &Smb4KClient::hostsChanged, this, &Smb4KDeclarative::slotHostsChanged);
+    connect(Smb4KClient::self(), &Smb4KClient::sharesChanged, this, &Smb4KDeclarative::slotSharesChanged);
     connect(Smb4KClient::self(), &Smb4KClient::aboutToStart, this, &Smb4KDeclarative::busy);
     connect(Smb4KClient::self(), &Smb4KClient::finished, this, &Smb4KDeclarative::idle);
     connect(Smb4KClient::self(), &Smb4KClient::requestCredentials, this, &Smb4KDeclarative::slotCredentialsRequested);
@@ -553,39 +620,101 @@ void Smb4KDeclarative::timerEvent(QTimerEvent *event)
     }
 }
 
-void Smb4KDeclarative::slotWorkgroupsListChanged()
+void Smb4KDeclarative::slotWorkgroupsChanged(const QList<WorkgroupPtr> &added, const QList<WorkgroupPtr> &removed, const QList<WorkgroupPtr> &changed)
 {
-    qDeleteAll(d->workgroupObjects);
-    d->workgroupObjects.clear();
+    //
+    // Remove the obsolete workgroups together with their members and shares
+    //
+    if (!removed.isEmpty()) {
+        QSet<QString> removedWorkgroups;
+
+        for (const WorkgroupPtr &workgroup : removed) {
+            removedWorkgroups << workgroup->workgroupName().toCaseFolded();
+        }
+
+        auto isObsolete = [&removedWorkgroups](Smb4KNetworkObject *object) {
+            return removedWorkgroups.contains(object->workgroupName().toCaseFolded());
+        };
+
+        removeNetworkObjects(&d->workgroupObjects, isObsolete);
 
-    for (const WorkgroupPtr &workgroup : Smb4KGlobal::workgroupsList()) {
-        d->workgroupObjects << new Smb4KNetworkObject(workgroup.data());
+        if (removeNetworkObjects(&d->hostObjects, isObsolete)) {
+            Q_EMIT hostsListChanged();
+        }
+
+        if (removeNetworkObjects(&d->shareObjects, isObsolete)) {
+            Q_EMIT sharesListChanged();
+        }
     }
 
+    //
+    // Update the changed workgroups and add the new ones
+    //
+    applyNetworkItems(&d->workgroupObjects, added, changed);
+
     Q_EMIT workgroupsListChanged();
 }
 
-void Smb4KDeclarative::slotHostsListChanged()
+void Smb4KDeclarative::slotHostsChanged(const WorkgroupPtr &workgroup,
+                                        const QList<HostPtr> &added,
+                                        const QList<HostPtr> &removed,
+                                        const QList<HostPtr> &changed)
 {
-    qDeleteAll(d->hostObjects);
-    d->hostObjects.clear();
+    Q_UNUSED(workgroup);
+
+    //
+    // Remove the obsolete hosts together with their shares
+    //
+    if (!removed.isEmpty()) {
+        QSet<QString> removedHosts;
+
+        for (const HostPtr &host : removed) {
+            removedHosts << host->workgroupName().toCaseFolded() + QStringLiteral("/") + host->hostName().toCaseFolded();
+        }
+
+        auto isObsolete = [&removedHosts](Smb4KNetworkObject *object) {
+            return removedHosts.contains(object->workgroupName().toCaseFolded() + QStringLiteral("/") + object->hostName().toCaseFolded());
+        };
+
+        removeNetworkObjects(&d->hostObjects, isObsolete);
 
-    for (const HostPtr &host : Smb4KGlobal::hostsList()) {
-        d->hostObjects << new Smb4KNetworkObject(host.data());
+        if (removeNetworkObjects(&d->shareObjects, isObsolete)) {
+            Q_EMIT sharesListChanged();
+        }
     }
 
+    //
+    // Update the changed hosts and add the new ones
+    //
+    applyNetworkItems(&d->hostObjects, added, changed);
+
     Q_EMIT hostsListChanged();
 }
 
-void Smb4KDeclarative::slotSharesListChanged()
+void Smb4KDeclarative::slotSharesChanged(const HostPtr &host, const QList<SharePtr> &added, const QList<SharePtr> &removed, const QList<SharePtr> &changed)
 {
-    qDeleteAll(d->shareObjects);
-    d->shareObjects.clear();
+    Q_UNUSED(host);
 
-    for (const SharePtr &share : Smb4KGlobal::sharesList()) {
-        d->shareObjects << new Smb4KNetworkObject(share.data());
+    //
+    // Remove the obsolete shares
+    //
+    if (!removed.isEmpty()) {
+        QSet<QString> removedShares;
+
+        for (const SharePtr &share : removed) {
+            removedShares << networkObjectKey(share->workgroupName(), share->url());
+        }
+
+        removeNetworkObjects(&d->shareObjects, [&removedShares](Smb4KNetworkObject *object) {
+            return removedShares.contains(networkObjectKey(object->workgroupName(), object->url()));
+        });
     }
 
+    //
+    // Update the changed shares and add the new ones
+    //
+    applyNetworkItems(&d->shareObjects, added, changed);
+
     Q_EMIT sharesListChanged();
 }
 
@@ -355,25 +355,25 @@ Q_SIGNALS:
 
 protected Q_SLOTS:
     /**
-     * This slot is invoked, when the list of workgroups was changed by
-     * the scanner. It rebuilds the workgroups() list and emits the
-     * worgroupsListChanged() signal.
+     * This slot is invoked, when workgroups were added, removed or changed
+     * by the scanner. It applies the changes to the workgroups() list and
+     * emits the workgroupsListChanged() signal.
      */
-    void slotWorkgroupsListChanged();
+    void slotWorkgroupsChanged(const QList<WorkgroupPtr> &added, const QList<WorkgroupPtr> &removed, const QList<WorkgroupPtr> &changed);
 
     /**
-     * This slot is invoked, when the list of hosts was changed by the
-     * scanner. It rebuilds the hosts() list and emits the hostsListChanged()
-     * signal.
+     * This slot is invoked, when hosts were added, removed or changed by the
+     * scanner. It applies the changes to the hosts() list and emits the
+     * hostsListChanged() signal.
      */
-    void slotHostsListChanged();
+    void slotHostsChanged(const WorkgroupPtr &workgroup, const QList<HostPtr> &added, const QList<HostPtr> &removed, const QList<HostPtr> &changed);
 
     /**
-     * This slot is invoked, when the list of shares was changed by the
-     * scanner. It rebuilds the shares() list and emits the sharesListChanged()
-     * signal.
+     * This slot is invoked, when shares were added, removed or changed by the
+     * scanner. It applies the changes to the shares() list and emits the
+     * sharesListChanged() signal.
      */
-    void slotSharesListChanged();
+    void slotSharesChanged(const HostPtr &host, const QList<SharePtr> &added, const QList<SharePtr> &removed, const QList<SharePtr> &changed);
 
     /**
      * This slot is invoked, when the list of mounted shares was changed
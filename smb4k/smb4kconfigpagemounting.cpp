@@ -143,12 +143,37 @@ void Smb4KConfigPageMounting::setupWidget()
     QCheckBox *detectAllShares = new QCheckBox(Smb4KMountSettings::self()->detectAllSharesItem()->label(), behaviorBox);
     detectAllShares->setObjectName(QStringLiteral("kcfg_DetectAllShares"));
 
+    QWidget *checkBudgetWidget = new QWidget(behaviorBox);
+    QGridLayout *checkBudgetWidgetLayout = new QGridLayout(checkBudgetWidget);
+    checkBudgetWidgetLayout->setContentsMargins(0, 0, 0, 0);
+
+    QLabel *checkBudgetLabel = new QLabel(Smb4KMountSettings::self()->checkBudgetItem()->label(), checkBudgetWidget);
+    checkBudgetLabel->setObjectName(QStringLiteral("CheckBudgetLabel"));
+
+    QSpinBox *checkBudget = new QSpinBox(checkBudgetWidget);
+    checkBudget->setObjectName(QStringLiteral("kcfg_CheckBudget"));
+    checkBudgetLabel->setBuddy(checkBudget);
+
+    QLabel *mountTimeoutLabel = new QLabel(Smb4KMountSettings::self()->mountTimeoutItem()->label(), checkBudgetWidget);
+    mountTimeoutLabel->setObjectName(QStringLiteral("MountTimeoutLabel"));
+
+    QSpinBox *mountTimeout = new QSpinBox(checkBudgetWidget);
+    mountTimeout->setObjectName(QStringLiteral("kcfg_MountTimeout"));
+    mountTimeout->setSuffix(i18n(" s"));
+    mountTimeoutLabel->setBuddy(mountTimeout);
+
+    checkBudgetWidgetLayout->addWidget(checkBudgetLabel, 0, 0);
+    checkBudgetWidgetLayout->addWidget(checkBudget, 0, 1);
+    checkBudgetWidgetLayout->addWidget(mountTimeoutLabel, 1, 0);
+    checkBudgetWidgetLayout->addWidget(mountTimeout, 1, 1);
+
     behaviorBoxLayout->addWidget(remountShares);
     behaviorBoxLayout->addWidget(m_remountSettingsWidget);
     behaviorBoxLayout->addWidget(checkServerOnlineState);
     behaviorBoxLayout->addWidget(unmountAllShares);
     behaviorBoxLayout->addWidget(unmountInaccessibleShares);
     behaviorBoxLayout->addWidget(detectAllShares);
+    behaviorBoxLayout->addWidget(checkBudgetWidget);
 
     basicTabLayout->addWidget(behaviorBox, 0);
     basicTabLayout->addStretch(100);
@@ -446,11 +471,36 @@ void Smb4KConfigPageMounting::setupWidget()
     QCheckBox *detectAllShares = new QCheckBox(Smb4KMountSettings::self()->detectAllSharesItem()->label(), behaviorBox);
     detectAllShares->setObjectName(QStringLiteral("kcfg_DetectAllShares"));
 
+    QWidget *checkBudgetWidget = new QWidget(behaviorBox);
+    QGridLayout *checkBudgetWidgetLayout = new QGridLayout(checkBudgetWidget);
+    checkBudgetWidgetLayout->setContentsMargins(0, 0, 0, 0);
+
+    QLabel *checkBudgetLabel = new QLabel(Smb4KMountSettings::self()->checkBudgetItem()->label(), checkBudgetWidget);
+    checkBudgetLabel->setObjectName(QStringLiteral("CheckBudgetLabel"));
+
+    QSpinBox *checkBudget = new QSpinBox(checkBudgetWidget);
+    checkBudget->setObjectName(QStringLiteral("kcfg_CheckBudget"));
+    checkBudgetLabel->setBuddy(checkBudget);
+
+    QLabel *mountTimeoutLabel = new QLabel(Smb4KMountSettings::self()->mountTimeoutItem()->label(), checkBudgetWidget);
+    mountTimeoutLabel->setObjectName(QStringLiteral("MountTimeoutLabel"));
+
+    QSpinBox *mountTimeout = new QSpinBox(checkBudgetWidget);
+    mountTimeout->setObjectName(QStringLiteral("kcfg_MountTimeout"));
+    mountTimeout->setSuffix(i18n(" s"));
+    mountTimeoutLabel->setBuddy(mountTimeout);
+
+    checkBudgetWidgetLayout->addWidget(checkBudgetLabel, 0, 0);
+    checkBudgetWidgetLayout->addWidget(checkBudget, 0, 1);
+    checkBudgetWidgetLayout->addWidget(mountTimeoutLabel, 1, 0);
+    checkBudgetWidgetLayout->addWidget(mountTimeout, 1, 1);
+
     behaviorBoxLayout->addWidget(remountShares);
     behaviorBoxLayout->addWidget(m_remountSettingsWidget);
     behaviorBoxLayout->addWidget(checkServerOnlineState);
     behaviorBoxLayout->addWidget(unmountAllShares);
     behaviorBoxLayout->addWidget(detectAllShares);
+    behaviorBoxLayout->addWidget(checkBudgetWidget);
 
     basicTabLayout->addWidget(behaviorBox, 0);
     basicTabLayout->addStretch(100);
@@ -120,6 +120,11 @@ Smb4KConfigPageNetwork::Smb4KConfigPageNetwork(QWidget *parent)
 
     behaviorBoxLayout->addWidget(previewHiddenItems, 1, 0);
 
+    QCheckBox *rememberNetworkNeighborhood = new QCheckBox(Smb4KSettings::self()->rememberNetworkNeighborhoodItem()->label(), behaviorBox);
+    rememberNetworkNeighborhood->setObjectName(QStringLiteral("kcfg_RememberNetworkNeighborhood"));
+
+    behaviorBoxLayout->addWidget(rememberNetworkNeighborhood, 1, 1);
+
     basicTabLayout->addWidget(behaviorBox);
     basicTabLayout->addStretch(100);
 
@@ -175,6 +180,30 @@ Smb4KConfigPageNetwork::Smb4KConfigPageNetwork(QWidget *parent)
 
     advancedTabLayout->addWidget(sambaBox);
 
+    QGroupBox *searchBox = new QGroupBox(i18n("Network Search"), advancedTab);
+    QGridLayout *searchBoxLayout = new QGridLayout(searchBox);
+
+    QLabel *searchParallelismLabel = new QLabel(Smb4KSettings::self()->searchParallelismItem()->label(), searchBox);
+    searchBoxLayout->addWidget(searchParallelismLabel, 0, 0);
+
+    QSpinBox *searchParallelism = new QSpinBox(searchBox);
+    searchParallelism->setObjectName(QStringLiteral("kcfg_SearchParallelism"));
+    searchParallelism->setSingleStep(1);
+
+    searchBoxLayout->addWidget(searchParallelism, 0, 1);
+
+    QLabel *searchHostTimeoutLabel = new QLabel(Smb4KSettings::self()->searchHostTimeoutItem()->label(), searchBox);
+    searchBoxLayout->addWidget(searchHostTimeoutLabel, 1, 0);
+
+    QSpinBox *searchHostTimeout = new QSpinBox(searchBox);
+    searchHostTimeout->setObjectName(QStringLiteral("kcfg_SearchHostTimeout"));
+    searchHostTimeout->setSuffix(i18n(" s"));
+    searchHostTimeout->setSingleStep(1);
+
+    searchBoxLayout->addWidget(searchHostTimeout, 1, 1);
+
+    advancedTabLayout->addWidget(searchBox);
+
     QGroupBox *wakeOnLanBox = new QGroupBox(i18n("Wake-On-LAN"), advancedTab);
     QVBoxLayout *wakeOnLanBoxLayout = new QVBoxLayout(wakeOnLanBox);
 
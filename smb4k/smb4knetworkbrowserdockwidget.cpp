@@ -27,6 +27,7 @@
 
 // Qt includes
 #include <QApplication>
+#include <QHash>
 #include <QHeaderView>
 #include <QMenu>
 #include <QPointer>
@@ -76,7 +77,9 @@ Smb4KNetworkBrowserDockWidget::Smb4KNetworkBrowserDockWidget(const QString &titl
 
     connect(Smb4KClient::self(), &Smb4KClient::aboutToStart, this, &Smb4KNetworkBrowserDockWidget::slotClientAboutToStart);
     connect(Smb4KClient::self(), &Smb4KClient::finished, this, &Smb4KNetworkBrowserDockWidget::slotClientFinished);
-    connect(Smb4KClient::self(), &Smb4KClient::workgroups, this, &Smb4KNetworkBrowserDockWidget::slotWorkgroups);
+    connect(Smb4KClient::self(), &Smb4KClient::workgroupsChanged, this, &Smb4KNetworkBrowserDockWidget::slotWorkgroupsChanged);
+    connect(Smb4KClient::self(), &Smb4KClient::hostsChanged, this, &Smb4KNetworkBrowserDockWidget::slotHostsChanged);
+    connect(Smb4KClient::self(), &Smb4KClient::sharesChanged, this, &Smb4KNetworkBrowserDockWidget::slotSharesChanged);
     connect(Smb4KClient::self(), &Smb4KClient::hosts, this, &Smb4KNetworkBrowserDockWidget::slotWorkgroupMembers);
     connect(Smb4KClient::self(), &Smb4KClient::shares, this, &Smb4KNetworkBrowserDockWidget::slotShares);
     connect(Smb4KClient::self(), &Smb4KClient::searchResults, this, &Smb4KNetworkBrowserDockWidget::slotSearchResults);
@@ -483,233 +486,250 @@ void Smb4KNetworkBrowserDockWidget::slotClientFinished(const NetworkItemPtr &ite
 
     if (process == NetworkSearch) {
         m_searchToolBar->setActiveState(false);
+        m_searchRunning = false;
     }
 }
 
-void Smb4KNetworkBrowserDockWidget::slotWorkgroups()
+void Smb4KNetworkBrowserDockWidget::slotWorkgroupsChanged(const QList<WorkgroupPtr> &added, const QList<WorkgroupPtr> &removed, const QList<WorkgroupPtr> &changed)
 {
-    if (!workgroupsList().isEmpty()) {
-        //
-        // Remove obsolete workgroups and update existing ones
-        //
-        QTreeWidgetItemIterator itemIt(m_networkBrowser, QTreeWidgetItemIterator::All);
+    //
+    // Index the workgroup items by their name
+    //
+    QHash<QString, Smb4KNetworkBrowserItem *> workgroupItems;
 
-        while (*itemIt) {
-            Smb4KNetworkBrowserItem *networkItem = static_cast<Smb4KNetworkBrowserItem *>(*itemIt);
+    for (int i = 0; i < m_networkBrowser->topLevelItemCount(); ++i) {
+        Smb4KNetworkBrowserItem *workgroupItem = static_cast<Smb4KNetworkBrowserItem *>(m_networkBrowser->topLevelItem(i));
 
-            if (networkItem->type() == Workgroup) {
-                WorkgroupPtr workgroup = findWorkgroup(networkItem->workgroupItem()->workgroupName());
+        if (workgroupItem->type() == Workgroup) {
+            workgroupItems.insert(workgroupItem->workgroupItem()->workgroupName().toCaseFolded(), workgroupItem);
+        }
+    }
 
-                if (workgroup) {
-                    networkItem->update();
+    //
+    // Remove obsolete workgroups together with their members
+    //
+    for (const WorkgroupPtr &workgroup : removed) {
+        delete workgroupItems.take(workgroup->workgroupName().toCaseFolded());
+    }
 
-                    // Update the master browser
-                    for (int i = 0; i < networkItem->childCount(); ++i) {
-                        Smb4KNetworkBrowserItem *host = static_cast<Smb4KNetworkBrowserItem *>(networkItem->child(i));
-                        host->update();
-                    }
-                } else {
-                    delete networkItem;
-                }
-            }
+    //
+    // Update the changed workgroups and their master browsers
+    //
+    for (const WorkgroupPtr &workgroup : changed) {
+        Smb4KNetworkBrowserItem *workgroupItem = workgroupItems.value(workgroup->workgroupName().toCaseFolded());
 
-            ++itemIt;
+        if (workgroupItem) {
+            workgroupItem->update();
+
+            for (int i = 0; i < workgroupItem->childCount(); ++i) {
+                Smb4KNetworkBrowserItem *hostItem = static_cast<Smb4KNetworkBrowserItem *>(workgroupItem->child(i));
+                hostItem->update();
+            }
         }
+    }
 
-        //
-        // Add new workgroups to the tree widget
-        //
-        for (const WorkgroupPtr &workgroup : workgroupsList()) {
-            QList<QTreeWidgetItem *> items = m_networkBrowser->findItems(workgroup->workgroupName(), Qt::MatchFixedString, Smb4KNetworkBrowser::Network);
+    //
+    // Add new workgroups to the tree widget
+    //
+    for (const WorkgroupPtr &workgroup : added) {
+        QString key = workgroup->workgroupName().toCaseFolded();
 
-            if (items.isEmpty()) {
-                (void)new Smb4KNetworkBrowserItem(m_networkBrowser, workgroup);
-            }
+        if (!workgroupItems.contains(key)) {
+            workgroupItems.insert(key, new Smb4KNetworkBrowserItem(m_networkBrowser, workgroup));
         }
+    }
 
-        //
-        // Sort the items
-        //
+    //
+    // Sort the items
+    //
+    if (!added.isEmpty() || !changed.isEmpty()) {
         m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
-    } else {
-        //
-        // Clear the tree widget
-        //
-        m_networkBrowser->clear();
     }
 }
 
-void Smb4KNetworkBrowserDockWidget::slotWorkgroupMembers(const WorkgroupPtr &workgroup)
+void Smb4KNetworkBrowserDockWidget::slotHostsChanged(const WorkgroupPtr &workgroup,
+                                                     const QList<HostPtr> &added,
+                                                     const QList<HostPtr> &removed,
+                                                     const QList<HostPtr> &changed)
 {
-    if (workgroup) {
-        //
-        // Find the right workgroup
-        //
-        QList<QTreeWidgetItem *> workgroups =
-            m_networkBrowser->findItems(workgroup->workgroupName(), Qt::MatchFixedString | Qt::MatchRecursive, Smb4KNetworkBrowser::Network);
-        Smb4KNetworkBrowserItem *workgroupItem = nullptr;
+    Smb4KNetworkBrowserItem *workgroupItem = findWorkgroupItem(workgroup->workgroupName());
 
-        for (QTreeWidgetItem *item : std::as_const(workgroups)) {
-            Smb4KNetworkBrowserItem *tempWorkgroup = static_cast<Smb4KNetworkBrowserItem *>(item);
+    if (!workgroupItem) {
+        return;
+    }
 
-            if (tempWorkgroup->type() == Workgroup && tempWorkgroup->workgroupItem()->workgroupName() == workgroup->workgroupName()) {
-                workgroupItem = tempWorkgroup;
-                break;
-            }
+    //
+    // Index the host items by their name
+    //
+    QHash<QString, Smb4KNetworkBrowserItem *> hostItems;
+
+    for (int i = 0; i < workgroupItem->childCount(); ++i) {
+        Smb4KNetworkBrowserItem *hostItem = static_cast<Smb4KNetworkBrowserItem *>(workgroupItem->child(i));
+        hostItems.insert(hostItem->hostItem()->hostName().toCaseFolded(), hostItem);
+    }
+
+    //
+    // Remove obsolete hosts together with their shares
+    //
+    for (const HostPtr &host : removed) {
+        delete hostItems.take(host->hostName().toCaseFolded());
+    }
+
+    //
+    // Update the changed hosts
+    //
+    for (const HostPtr &host : changed) {
+        Smb4KNetworkBrowserItem *hostItem = hostItems.value(host->hostName().toCaseFolded());
+
+        if (hostItem) {
+            hostItem->update();
         }
+    }
 
-        //
-        // Process the hosts
-        //
-        if (workgroupItem) {
-            //
-            // Remove obsolete hosts and update existing ones
-            //
-            QTreeWidgetItemIterator hostIt(workgroupItem);
+    //
+    // Add new hosts to the workgroup item. Only honor the hosts that
+    // actually belong to the workgroup.
+    //
+    for (const HostPtr &host : added) {
+        QString key = host->hostName().toCaseFolded();
 
-            while (*hostIt) {
-                Smb4KNetworkBrowserItem *hostItem = static_cast<Smb4KNetworkBrowserItem *>(*hostIt);
+        if (QString::compare(host->workgroupName(), workgroup->workgroupName(), Qt::CaseInsensitive) == 0 && !hostItems.contains(key)) {
+            hostItems.insert(key, new Smb4KNetworkBrowserItem(workgroupItem, host));
+        }
+    }
 
-                if (hostItem->type() == Host) {
-                    HostPtr host = findHost(hostItem->hostItem()->hostName(), hostItem->hostItem()->workgroupName());
+    //
+    // Sort the items
+    //
+    if (!added.isEmpty() || !changed.isEmpty()) {
+        m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
+    }
+}
 
-                    if (host) {
-                        hostItem->update();
-                    } else {
-                        delete hostItem;
-                    }
-                }
+void Smb4KNetworkBrowserDockWidget::slotSharesChanged(const HostPtr &host,
+                                                      const QList<SharePtr> &added,
+                                                      const QList<SharePtr> &removed,
+                                                      const QList<SharePtr> &changed)
+{
+    Smb4KNetworkBrowserItem *hostItem = findHostItem(host);
 
-                ++hostIt;
-            }
+    if (!hostItem) {
+        return;
+    }
 
-            //
-            // Add new hosts to the workgroup item and remove obsolete workgroups if
-            // necessary. Honor the auto-expand feature.
-            //
-            QList<HostPtr> members = workgroupMembers(workgroup);
+    //
+    // Index the share items by their URL
+    //
+    QHash<QString, Smb4KNetworkBrowserItem *> shareItems;
 
-            if (!members.isEmpty()) {
-                for (const HostPtr &host : std::as_const(members)) {
-                    bool foundHost = false;
+    for (int i = 0; i < hostItem->childCount(); ++i) {
+        Smb4KNetworkBrowserItem *shareItem = static_cast<Smb4KNetworkBrowserItem *>(hostItem->child(i));
+        shareItems.insert(shareItem->shareItem()->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded(), shareItem);
+    }
 
-                    for (int i = 0; i < workgroupItem->childCount(); ++i) {
-                        Smb4KNetworkBrowserItem *hostItem = static_cast<Smb4KNetworkBrowserItem *>(workgroupItem->child(i));
+    //
+    // Remove obsolete shares
+    //
+    for (const SharePtr &share : removed) {
+        delete shareItems.take(share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded());
+    }
 
-                        if (hostItem->hostItem()->hostName() == host->hostName()) {
-                            foundHost = true;
-                            break;
-                        }
-                    }
+    //
+    // Update the changed shares
+    //
+    for (const SharePtr &share : changed) {
+        Smb4KNetworkBrowserItem *shareItem = shareItems.value(share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded());
 
-                    if (!foundHost) {
-                        (void)new Smb4KNetworkBrowserItem(workgroupItem, host);
-                    }
-                }
+        if (shareItem) {
+            shareItem->update();
+        }
+    }
 
-                //
-                // Auto-expand the workgroup item, if applicable
-                //
-                if (Smb4KSettings::autoExpandNetworkItems() && !workgroupItem->isExpanded() && !m_searchRunning) {
-                    m_networkBrowser->expandItem(workgroupItem);
-                }
-            } else {
-                //
-                // Remove empty workgroup.
-                //
-                delete workgroupItem;
-            }
+    //
+    // Add new shares to the host item
+    //
+    for (const SharePtr &share : added) {
+        QString key = share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded();
 
-            //
-            // Sort the items
-            //
-            m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
+        if (!shareItems.contains(key)) {
+            shareItems.insert(key, new Smb4KNetworkBrowserItem(hostItem, share));
         }
     }
+
+    //
+    // Sort the items
+    //
+    if (!added.isEmpty() || !changed.isEmpty()) {
+        m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
+    }
 }
 
-void Smb4KNetworkBrowserDockWidget::slotShares(const HostPtr &host)
+void Smb4KNetworkBrowserDockWidget::slotWorkgroupMembers(const WorkgroupPtr &workgroup)
 {
-    if (host) {
-        //
-        // Find the right host
-        //
-        QList<QTreeWidgetItem *> hosts = m_networkBrowser->findItems(host->hostName(), Qt::MatchFixedString | Qt::MatchRecursive, Smb4KNetworkBrowser::Network);
-        Smb4KNetworkBrowserItem *hostItem = nullptr;
-
-        for (QTreeWidgetItem *item : std::as_const(hosts)) {
-            Smb4KNetworkBrowserItem *tempHost = static_cast<Smb4KNetworkBrowserItem *>(item);
+    Smb4KNetworkBrowserItem *workgroupItem = workgroup ? findWorkgroupItem(workgroup->workgroupName()) : nullptr;
 
-            if (tempHost->type() == Host && tempHost->hostItem()->workgroupName() == host->workgroupName()) {
-                hostItem = tempHost;
-                break;
+    if (workgroupItem) {
+        if (workgroupItem->childCount() != 0) {
+            //
+            // Auto-expand the workgroup item, if applicable
+            //
+            if (Smb4KSettings::autoExpandNetworkItems() && !workgroupItem->isExpanded() && !m_searchRunning) {
+                m_networkBrowser->expandItem(workgroupItem);
             }
-        }
-
-        //
-        // Process the shares
-        //
-        if (hostItem) {
+        } else {
             //
-            // Remove obsolete shares and update existing ones
+            // Remove empty workgroup.
             //
-            QTreeWidgetItemIterator shareIt(hostItem);
-
-            while (*shareIt) {
-                Smb4KNetworkBrowserItem *shareItem = static_cast<Smb4KNetworkBrowserItem *>(*shareIt);
-
-                if (shareItem->type() == Share) {
-                    SharePtr share = findShare(shareItem->shareItem()->url(), shareItem->shareItem()->workgroupName());
+            delete workgroupItem;
+        }
+    }
+}
 
-                    if (share) {
-                        shareItem->update();
-                    } else {
-                        delete shareItem;
-                    }
-                }
+void Smb4KNetworkBrowserDockWidget::slotShares(const HostPtr &host)
+{
+    //
+    // The host will not be removed from the view when it has no shares.
+    // Honor the auto-expand feature.
+    //
+    Smb4KNetworkBrowserItem *hostItem = findHostItem(host);
 
-                ++shareIt;
-            }
+    if (hostItem && hostItem->childCount() != 0) {
+        if (Smb4KSettings::autoExpandNetworkItems() && !hostItem->isExpanded() && !m_searchRunning) {
+            m_networkBrowser->expandItem(hostItem);
+        }
+    }
+}
 
-            //
-            // Add new shares to the host item. The host will not be removed from the
-            // view when it has no shares. Honor the auto-expand feature.
-            //
-            QList<SharePtr> shares = sharedResources(host);
+Smb4KNetworkBrowserItem *Smb4KNetworkBrowserDockWidget::findWorkgroupItem(const QString &workgroupName)
+{
+    for (int i = 0; i < m_networkBrowser->topLevelItemCount(); ++i) {
+        Smb4KNetworkBrowserItem *workgroupItem = static_cast<Smb4KNetworkBrowserItem *>(m_networkBrowser->topLevelItem(i));
 
-            if (!shares.isEmpty()) {
-                for (const SharePtr &share : std::as_const(shares)) {
-                    bool foundShare = false;
+        if (workgroupItem->type() == Workgroup && QString::compare(workgroupItem->workgroupItem()->workgroupName(), workgroupName, Qt::CaseInsensitive) == 0) {
+            return workgroupItem;
+        }
+    }
 
-                    for (int i = 0; i < hostItem->childCount(); ++i) {
-                        Smb4KNetworkBrowserItem *shareItem = static_cast<Smb4KNetworkBrowserItem *>(hostItem->child(i));
+    return nullptr;
+}
 
-                        if (shareItem->shareItem()->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort)
-                            == share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort)) {
-                            foundShare = true;
-                            break;
-                        }
-                    }
+Smb4KNetworkBrowserItem *Smb4KNetworkBrowserDockWidget::findHostItem(const HostPtr &host)
+{
+    if (host) {
+        Smb4KNetworkBrowserItem *workgroupItem = findWorkgroupItem(host->workgroupName());
 
-                    if (!foundShare) {
-                        (void)new Smb4KNetworkBrowserItem(hostItem, share);
-                    }
-                }
+        if (workgroupItem) {
+            for (int i = 0; i < workgroupItem->childCount(); ++i) {
+                Smb4KNetworkBrowserItem *hostItem = static_cast<Smb4KNetworkBrowserItem *>(workgroupItem->child(i));
 
-                //
-                // Auto-expand the host item, if applicable
-                //
-                if (Smb4KSettings::autoExpandNetworkItems() && !hostItem->isExpanded() && !m_searchRunning) {
-                    m_networkBrowser->expandItem(hostItem);
+                if (QString::compare(hostItem->hostItem()->hostName(), host->hostName(), Qt::CaseInsensitive) == 0) {
+                    return hostItem;
                 }
             }
         }
-
-        //
-        // Sort the items
-        //
-        m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
     }
+
+    return nullptr;
 }
 
 void Smb4KNetworkBrowserDockWidget::slotRescanAbortActionTriggered(bool checked)
@@ -1086,7 +1106,10 @@ void Smb4KNetworkBrowserDockWidget::slotStopSearch()
 
 void Smb4KNetworkBrowserDockWidget::slotSearchResults(const QList<SharePtr> &shares)
 {
-    m_searchRunning = false;
+    //
+    // The results arrive in batches while the search is running
+    //
+    bool firstResults = m_networkBrowser->selectedItems().isEmpty();
     QTreeWidgetItemIterator it(m_networkBrowser);
 
     while (*it) {
@@ -1111,8 +1134,10 @@ void Smb4KNetworkBrowserDockWidget::slotSearchResults(const QList<SharePtr> &sha
         it++;
     }
 
-    QTreeWidgetItem *firstItem = m_networkBrowser->selectedItems().first();
-    m_networkBrowser->scrollToItem(firstItem, QTreeWidget::PositionAtCenter);
+    if (firstResults && !m_networkBrowser->selectedItems().isEmpty()) {
+        QTreeWidgetItem *firstItem = m_networkBrowser->selectedItems().first();
+        m_networkBrowser->scrollToItem(firstItem, QTreeWidget::PositionAtCenter);
+    }
 
     m_searchToolBar->setSearchResults(shares);
 }
@@ -24,6 +24,7 @@ using namespace Smb4KGlobal;
 
 // Forward declarations
 class Smb4KNetworkBrowser;
+class Smb4KNetworkBrowserItem;
 class Smb4KNetworkSearchToolBar;
 class Smb4KPasswordDialog;
 
@@ -99,9 +100,33 @@ protected Q_SLOTS:
     void slotClientFinished(const NetworkItemPtr &item, int process);
 
     /**
-     * This slot is called when workgroups/domains were discovered
+     * This slot is called when workgroups/domains were added, removed or
+     * changed. Only the affected items are touched.
+     * @param added               The new workgroups/domains
+     * @param removed             The obsolete workgroups/domains
+     * @param changed             The changed workgroups/domains
      */
-    void slotWorkgroups();
+    void slotWorkgroupsChanged(const QList<WorkgroupPtr> &added, const QList<WorkgroupPtr> &removed, const QList<WorkgroupPtr> &changed);
+
+    /**
+     * This slot is called when servers of the workgroup/domain @p workgroup
+     * were added, removed or changed.
+     * @param workgroup           The workgroup/domain
+     * @param added               The new servers
+     * @param removed             The obsolete servers
+     * @param changed             The changed servers
+     */
+    void slotHostsChanged(const WorkgroupPtr &workgroup, const QList<HostPtr> &added, const QList<HostPtr> &removed, const QList<HostPtr> &changed);
+
+    /**
+     * This slot is called when shared resources of the host @p host were
+     * added, removed or changed.
+     * @param host                The host
+     * @param added               The new shares
+     * @param removed             The obsolete shares
+     * @param changed             The changed shares
+     */
+    void slotSharesChanged(const HostPtr &host, const QList<SharePtr> &added, const QList<SharePtr> &removed, const QList<SharePtr> &changed);
 
     /**
      * This slot is called when the list of servers of workgroup/domain
@@ -250,6 +275,8 @@ protected Q_SLOTS:
 
 private:
     void setupActions();
+    Smb4KNetworkBrowserItem *findWorkgroupItem(const QString &workgroupName);
+    Smb4KNetworkBrowserItem *findHostItem(const HostPtr &host);
     Smb4KNetworkBrowser *m_networkBrowser;
     KActionCollection *m_actionCollection;
     KActionMenu *m_contextMenu;
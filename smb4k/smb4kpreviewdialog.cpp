@@ -11,9 +11,11 @@
 #include "core/smb4ksettings.h"
 #include "smb4khomesuserdialog.h"
 
+// System includes
+#include <algorithm>
+
 // Qt includes
 #include <QDialogButtonBox>
-#include <QMap>
 #include <QVBoxLayout>
 
 // KDE includes
@@ -30,6 +32,8 @@ Smb4KPreviewDialog::Smb4KPreviewDialog(QWidget *parent)
     setWindowTitle(i18n("Preview Dialog"));
     setAttribute(Qt::WA_DeleteOnClose, true);
 
+    m_partialResults = false;
+
     QVBoxLayout *layout = new QVBoxLayout(this);
 
     m_listWidget = new QListWidget(this);
@@ -93,6 +97,7 @@ Smb4KPreviewDialog::Smb4KPreviewDialog(QWidget *parent)
     resize(dialogSize); // workaround for QTBUG-40584
 
     connect(Smb4KClient::self(), &Smb4KClient::files, this, &Smb4KPreviewDialog::slotPreviewResults);
+    connect(Smb4KClient::self(), &Smb4KClient::filesDiscovered, this, &Smb4KPreviewDialog::slotPartialPreviewResults);
     connect(Smb4KClient::self(), &Smb4KClient::aboutToStart, this, &Smb4KPreviewDialog::slotAdjustReloadAction);
     connect(Smb4KClient::self(), &Smb4KClient::finished, this, &Smb4KPreviewDialog::slotAdjustReloadAction);
 }
@@ -148,6 +153,7 @@ void Smb4KPreviewDialog::loadPreview(const NetworkItemPtr &networkItem)
     m_urlComboBox->setUrl(networkItem->url());
 
     m_currentItem = networkItem;
+    m_partialResults = false;
 
     Smb4KClient::self()->lookupFiles(networkItem);
 }
@@ -175,43 +181,89 @@ void Smb4KPreviewDialog::slotItemActivated(QListWidgetItem *item)
     }
 }
 
-void Smb4KPreviewDialog::slotPreviewResults(const QList<FilePtr> &files)
+void Smb4KPreviewDialog::addPreviewItem(const FilePtr &file)
 {
-    if (!files.first()->url().toString().startsWith(m_share->url().toString())) {
+    //
+    // Directories are listed before files. The items are inserted at
+    // their sorted position, so that the listing can grow while the
+    // lookup is still running.
+    //
+    QString sortingKey = (file->isDirectory() ? QStringLiteral("00_") : QStringLiteral("01_")) + file->name();
+    auto position = std::lower_bound(m_sortingKeys.begin(), m_sortingKeys.end(), sortingKey);
+
+    if (position != m_sortingKeys.end() && *position == sortingKey) {
         return;
     }
 
-    if (m_listWidget->count() != 0) {
-        m_listWidget->clear();
-    }
+    int row = position - m_sortingKeys.begin();
+    m_sortingKeys.insert(row, sortingKey);
 
-    QMap<QString, QListWidgetItem *> sortingMap;
+    QVariant variant = QVariant::fromValue(*file.data());
 
-    for (const FilePtr &file : files) {
-        QVariant variant = QVariant::fromValue(*file.data());
+    QListWidgetItem *item = new QListWidgetItem();
+    item->setText(file->name());
+    item->setIcon(file->icon());
+    item->setData(Qt::UserRole, variant);
 
-        QListWidgetItem *item = new QListWidgetItem();
-        item->setText(file->name());
-        item->setIcon(file->icon());
-        item->setData(Qt::UserRole, variant);
+    m_listWidget->insertItem(row, item);
+}
 
-        if (file->isDirectory()) {
-            sortingMap[QStringLiteral("00_") + file->name()] = item;
-        } else {
-            sortingMap[QStringLiteral("01_") + file->name()] = item;
-        }
+bool Smb4KPreviewDialog::isCurrentDirectory(const QUrl &url) const
+{
+    return m_currentItem && m_currentItem->url().matches(url, QUrl::RemoveUserInfo | QUrl::StripTrailingSlash);
+}
+
+void Smb4KPreviewDialog::slotPreviewResults(const QUrl &url, const QList<FilePtr> &files)
+{
+    //
+    // Ignore the results of other lookups, even if they are empty
+    //
+    if (!isCurrentDirectory(url)) {
+        return;
     }
 
-    QMapIterator<QString, QListWidgetItem *> it(sortingMap);
+    //
+    // If parts of the listing are already shown, only add the missing
+    // items. Otherwise replace the previous listing.
+    //
+    if (!m_partialResults) {
+        m_listWidget->clear();
+        m_sortingKeys.clear();
+    }
 
-    while (it.hasNext()) {
-        it.next();
-        m_listWidget->addItem(it.value());
+    for (const FilePtr &file : files) {
+        if (isCurrentDirectory(file->url().adjusted(QUrl::StripTrailingSlash).adjusted(QUrl::RemoveFilename))) {
+            addPreviewItem(file);
+        }
     }
 
+    m_partialResults = false;
+
     m_upAction->setEnabled(!m_currentItem->url().matches(m_share->url(), QUrl::StripTrailingSlash));
 }
 
+void Smb4KPreviewDialog::slotPartialPreviewResults(const QUrl &url, const QList<FilePtr> &files)
+{
+    if (!isCurrentDirectory(url)) {
+        return;
+    }
+
+    //
+    // Replace the previous listing with the first batch of results
+    //
+    if (!m_partialResults) {
+        m_listWidget->clear();
+        m_sortingKeys.clear();
+        m_partialResults = true;
+    }
+
+    for (const FilePtr &file : files) {
+        if (isCurrentDirectory(file->url().adjusted(QUrl::StripTrailingSlash).adjusted(QUrl::RemoveFilename))) {
+            addPreviewItem(file);
+        }
+    }
+}
+
 void Smb4KPreviewDialog::slotReloadActionTriggered(bool checked)
 {
     Q_UNUSED(checked);
@@ -52,13 +52,16 @@ public Q_SLOTS:
 protected Q_SLOTS:
     void slotCloseButtonClicked();
     void slotItemActivated(QListWidgetItem *item);
-    void slotPreviewResults(const QList<FilePtr> &files);
+    void slotPreviewResults(const QUrl &url, const QList<FilePtr> &files);
+    void slotPartialPreviewResults(const QUrl &url, const QList<FilePtr> &files);
     void slotReloadActionTriggered(bool checked);
     void slotUpActionTriggered();
     void slotUrlActivated(const QUrl &url);
     void slotAdjustReloadAction(const NetworkItemPtr &item, int type);
 
 private:
+    void addPreviewItem(const FilePtr &file);
+    bool isCurrentDirectory(const QUrl &url) const;
     QListWidget *m_listWidget;
     QPushButton *m_closeButton;
     SharePtr m_share;
@@ -66,6 +69,8 @@ private:
     KDualAction *m_reloadAction;
     QAction *m_upAction;
     KUrlComboBox *m_urlComboBox;
+    QStringList m_sortingKeys;
+    bool m_partialResults;
 };
 
 #endif
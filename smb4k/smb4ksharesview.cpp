@@ -7,6 +7,7 @@
 
 // application specific includes
 #include "smb4ksharesview.h"
+#include "core/smb4kmounter.h"
 #include "core/smb4ksettings.h"
 #include "core/smb4kshare.h"
 #include "smb4ksharesviewitem.h"
@@ -38,6 +39,11 @@ Smb4KSharesView::Smb4KSharesView(QWidget *parent)
 
     m_toolTip = new Smb4KToolTip(this);
 
+    // While the tool tip is shown, the shares are checked more often
+    connect(m_toolTip, &Smb4KToolTip::hidden, this, [this]() {
+        Smb4KMounter::self()->setSharesViewVisible(m_toolTip, false);
+    });
+
     setContextMenuPolicy(Qt::CustomContextMenu);
 }
 
@@ -90,11 +96,21 @@ bool Smb4KSharesView::event(QEvent *e)
             if (Smb4KSettings::showShareToolTip()) {
                 m_toolTip->setupToolTip(Smb4KToolTip::MountedShare, item->shareItem());
                 m_toolTip->show(cursor().pos(), nativeParentWidget()->windowHandle());
+                Smb4KMounter::self()->setSharesViewVisible(m_toolTip, true);
             }
         }
 
         break;
     }
+    case QEvent::Show: {
+        // The mounted shares are checked more often while they are shown
+        Smb4KMounter::self()->setSharesViewVisible(this, true);
+        break;
+    }
+    case QEvent::Hide: {
+        Smb4KMounter::self()->setSharesViewVisible(this, false);
+        break;
+    }
     default: {
         break;
     }